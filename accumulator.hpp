@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./simd.hpp"
+
+// Multiply-accumulate in the unshifted product scale.
+// A sum of products is kept in 64 bits for 8- and 16-bit bases and in
+// next_type otherwise (i128 for 64-bit bases), and only shifted, rounded
+// and overflow-checked once, when the result is read. That leaves about
+// 2^(63 - 2 * bits) products of full-range values for 16-bit bases, and
+// 2^(bits - 2 * int_bits) for 32-bit ones, before the wide sum itself
+// overflows. Past that it wraps around, as the SIMD kernels do.
+
+namespace fxd {
+
+namespace impl {
+
+template<fixed_point T>
+using wide_t = typename T::next_type;
+
+// The integer for long sums of products of B: next_int_v<B>, but at least
+// 64 bits.
+template<std::integral B>
+using sum_int_t = std::conditional_t<(sizeof(B) <= sizeof(i16)), std::conditional_t<std::is_signed_v<B>, i64, u64>,
+                                     next_int_v<B>>;
+
+template<fixed_point T, typename W = wide_t<T>>
+constexpr W wide_mul(T a, T b) {
+    return static_cast<W>(a.raw()) * static_cast<W>(b.raw());
+}
+
+// Lifts a plain value to the scale of a product, to mix it into a wide sum.
+template<fixed_point T, typename W = wide_t<T>>
+constexpr W widen(T a) {
+    return static_cast<W>(a.raw()) << T::frac_bits;
+}
+
+template<typename W>
+using wrapping_t = typename std::conditional_t<(sizeof(W) <= sizeof(u64)), std::make_unsigned<W>, std::type_identity<u128>>::type;
+
+// a + b and a - b, wrapping as the SIMD kernels do.
+template<typename W>
+constexpr W wrapping_add(W a, W b) {
+    return static_cast<W>(static_cast<wrapping_t<W>>(a) + static_cast<wrapping_t<W>>(b));
+}
+
+template<typename W>
+constexpr W wrapping_sub(W a, W b) {
+    return static_cast<W>(static_cast<wrapping_t<W>>(a) - static_cast<wrapping_t<W>>(b));
+}
+
+// A wide sum with `from` fraction bits, rounded and narrowed to T by its policies.
+template<fixed_point T, int from, typename W>
+constexpr T from_wide(W sum) {
+    constexpr int fp = T::frac_bits;
+    if constexpr(from > fp)
+        sum = round_shift<typename T::rounding_type>(sum, from - fp);
+    else if constexpr(from < fp)
+        sum = sum << (fp - from);
+    return T::from_raw(narrow<typename T::overflow_type, typename T::base_type>(sum));
+}
+
+}
+
+template<fixed_point T>
+class accumulator {
+public:
+    using fixed_t = T;
+    using wide_type = impl::sum_int_t<typename T::base_type>;
+
+    constexpr accumulator() = default;
+    constexpr explicit accumulator(T init) : sum(impl::widen<T, wide_type>(init)) {}
+
+    static constexpr accumulator from_raw(wide_type raw) {
+        accumulator out;
+        out.sum = raw;
+        return out;
+    }
+
+    constexpr wide_type raw() const { return sum; }
+
+    constexpr accumulator& mac(T a, T b) { return add(impl::wide_mul<T, wide_type>(a, b)); }
+    constexpr accumulator& msub(T a, T b) { return subtract(impl::wide_mul<T, wide_type>(a, b)); }
+
+    constexpr accumulator& operator+=(T a) { return add(impl::widen<T, wide_type>(a)); }
+    constexpr accumulator& operator-=(T a) { return subtract(impl::widen<T, wide_type>(a)); }
+    constexpr accumulator& operator+=(const accumulator& other) { return add(other.sum); }
+    constexpr accumulator& operator-=(const accumulator& other) { return subtract(other.sum); }
+
+    // The sum with T's rounding and overflow policies applied.
+    constexpr T result() const { return impl::from_wide<T, 2 * T::frac_bits>(sum); }
+    constexpr explicit operator T() const { return result(); }
+
+private:
+    constexpr accumulator& add(wide_type v) { sum = impl::wrapping_add(sum, v); return *this; }
+    constexpr accumulator& subtract(wide_type v) { sum = impl::wrapping_sub(sum, v); return *this; }
+
+    wide_type sum = 0;
+};
+
+namespace impl {
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+FXD_TARGET_AVX2 inline i64 hsum_epi64(__m256i v) {
+    const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return wrapping_add<i64>(_mm_cvtsi128_si64(half), _mm_extract_epi64(half, 1));
+}
+
+// Sum of raw products over whole blocks of eight. Returns how many elements
+// were processed and adds the sum to out.
+template<typename T>
+FXD_TARGET_AVX2 std::size_t dot(const T* a, const T* b, std::size_t n, i64& out) {
+    __m256i even = _mm256_setzero_si256();
+    __m256i odd  = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i va = load(a + i);
+        const __m256i vb = load(b + i);
+        even = _mm256_add_epi64(even, _mm256_mul_epi32(va, vb));
+        odd  = _mm256_add_epi64(odd, _mm256_mul_epi32(_mm256_srli_epi64(va, 32), _mm256_srli_epi64(vb, 32)));
+    }
+    out = wrapping_add(out, hsum_epi64(_mm256_add_epi64(even, odd)));
+    return i;
+}
+
+// dot for 16-bit lanes, over whole blocks of sixteen. pmaddwd adds pairs of
+// products in 32 bits, which only overflows when all four inputs are
+// -32768: 2^31 wraps to INT_MIN, which no pair sum reaches. Widening v - 1
+// and adding the 1 back per lane takes it to 2^31 again.
+template<typename T>
+FXD_TARGET_AVX2 std::size_t dot16(const T* a, const T* b, std::size_t n, i64& out) {
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i lo = _mm256_setzero_si256();
+    __m256i hi = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i pairs = _mm256_sub_epi32(_mm256_madd_epi16(load(a + i), load(b + i)), one);
+        lo = _mm256_add_epi64(lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(pairs)));
+        hi = _mm256_add_epi64(hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(pairs, 1)));
+    }
+    out = wrapping_add(out, wrapping_add(hsum_epi64(_mm256_add_epi64(lo, hi)), static_cast<i64>(i / 2)));
+    return i;
+}
+
+// Sum of raw values over whole blocks of eight, sign-extended to 64 bits.
+template<typename T>
+FXD_TARGET_AVX2 std::size_t sum(const T* x, std::size_t n, i64& out) {
+    __m256i lo = _mm256_setzero_si256();
+    __m256i hi = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i v = load(x + i);
+        lo = _mm256_add_epi64(lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        hi = _mm256_add_epi64(hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    out = wrapping_add(out, hsum_epi64(_mm256_add_epi64(lo, hi)));
+    return i;
+}
+
+}
+#endif
+}
+
+// Span reductions. Both are exact up to the final result(), so the SIMD
+// path is bit-identical to the scalar loop for every policy.
+
+template<fixed_point T>
+constexpr accumulator<T> dot(std::span<const T> a, std::span<const T> b, accumulator<T> acc = {}) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<typename T::base_type, i32>) {
+        if (!std::is_constant_evaluated() && impl::has_avx2()) {
+            i64 raw = 0;
+            i = impl::avx2::dot(a.data(), b.data(), a.size(), raw);
+            acc += accumulator<T>::from_raw(raw);
+        }
+    }
+    else if constexpr(std::is_same_v<typename T::base_type, i16>) {
+        if (!std::is_constant_evaluated() && impl::has_avx2()) {
+            i64 raw = 0;
+            i = impl::avx2::dot16(a.data(), b.data(), a.size(), raw);
+            acc += accumulator<T>::from_raw(raw);
+        }
+    }
+#endif
+    for (; i < a.size(); i++)
+        acc.mac(a[i], b[i]);
+    return acc;
+}
+
+template<fixed_point T>
+constexpr accumulator<T> sum(std::span<const T> x, accumulator<T> acc = {}) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<typename T::base_type, i32>) {
+        if (!std::is_constant_evaluated() && impl::has_avx2()) {
+            i64 raw = 0;
+            i = impl::avx2::sum(x.data(), x.size(), raw);
+            acc += accumulator<T>::from_raw(raw << T::frac_bits);
+        }
+    }
+#endif
+    for (; i < x.size(); i++)
+        acc += x[i];
+    return acc;
+}
+
+}
@@ -0,0 +1,409 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./math_helper.hpp"
+#include "./fast.hpp"
+#include "./simd.hpp"
+
+// Binary angles.
+//
+// angle<u16> and angle<u32> spread one turn over the whole range of the base,
+// so adding and subtracting angles wraps around for free. sin and cos take
+// the quadrant from the top two bits and a table index from the next seven,
+// and finish with the angle sum identities on what is left, so there is no
+// range reduction at all. angle16 is evaluated as an angle32 with its low bits
+// clear. Both are within 3 trig_t ulp of exact, and atan2 is within 3 steps
+// of an angle32. The span versions of sin, cos, sincos and atan2 run eight
+// lanes at a time with AVX2 and give the same bits; atan2 only for 32-bit
+// inputs.
+
+namespace fxd {
+
+template<std::unsigned_integral base> requires (sizeof(base) == 2 || sizeof(base) == 4)
+class angle;
+
+namespace impl {
+
+// sin(x) for x: [0, pi / 2], at compile time.
+consteval double taylor_sin(double x) {
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 16; i++) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+// sin(i * pi / 256) for i: [0, 128] in trig_t, so cos is the same table read
+// from the other end.
+consteval std::array<i32, 129> make_quarter_sin() {
+    std::array<i32, 129> out{};
+    for (int i = 0; i <= 128; i++)
+        out[i] = static_cast<i32>(taylor_sin(i * (3.1415926535897932385 / 256)) * (1 << trig_t::frac_bits) + 0.5);
+    return out;
+}
+
+constexpr inline std::array<i32, 129> quarter_sin = make_quarter_sin();
+
+// pi / 2 in Q31, which a 32-bit lane can multiply.
+constexpr u32 half_pi_q31 = q126_bits<u32>(half_pi_q126, 31);
+constexpr trig_t one_sixth = 0.16666666666666666667;
+
+// sin and cos of the angle32 a. The low 23 bits are under 1/512 of a turn,
+// so d - d^3 / 6 and 1 - d^2 / 2 both leave less than 2^-30.
+constexpr void angle_sincos(u32 a, trig_t& out_sin, trig_t& out_cos) {
+    const u32 quadrant = a >> 30;
+    const u32 index = (a >> 23) & 127;
+    const trig_t d = trig_t::from_raw(static_cast<i32>((u64(a & 0x7fffff) * half_pi_q31) >> 32 >> 2));
+
+    const trig_t d2 = d * d;
+    const trig_t sin_d = d - d * d2 * one_sixth;
+    const trig_t cos_d = 1 - (d2 >> 1);
+    const trig_t s = trig_t::from_raw(quarter_sin[index]);
+    const trig_t c = trig_t::from_raw(quarter_sin[128 - index]);
+
+    const trig_t y_sin = s * cos_d + c * sin_d;
+    const trig_t y_cos = c * cos_d - s * sin_d;
+
+    out_sin = (quadrant & 1) ? y_cos : y_sin;
+    out_cos = (quadrant & 1) ? y_sin : y_cos;
+    if (quadrant & 2)
+        out_sin = -out_sin;
+    if (quadrant == 1 || quadrant == 2)
+        out_cos = -out_cos;
+}
+
+// atan2(y, x) as an angle32. The octant comes from the signs and from which
+// of |y| and |x| is larger, so the polynomial only sees [0, 1].
+using atan2_work_t = fixed<i32, 30, overflow::wrap, rounding::half_up>;
+constexpr u64 two_by_pi_q32 = q126_bits<u64>(two_by_pi_q126, 32);
+
+template<std::integral base, int fp>
+constexpr u32 angle_atan2(fixed<base, fp> y, fixed<base, fp> x) {
+    using uw = std::conditional_t<(sizeof(base) > sizeof(i32)), u128, u64>;
+    using work_t = atan2_work_t;
+    constexpr u64 two_by_pi = two_by_pi_q32;
+
+    const uw ay = (y < 0) ? uw(0) - static_cast<uw>(y.raw()) : static_cast<uw>(y.raw());
+    const uw ax = (x < 0) ? uw(0) - static_cast<uw>(x.raw()) : static_cast<uw>(x.raw());
+    if (ay == 0 && ax == 0)
+        return 0;
+
+    const bool steep = ay > ax;
+    const uw t = ((steep ? ax : ay) << work_t::frac_bits) / (steep ? ay : ax);
+    const work_t r = fast_atan<30>(work_t::from_raw(static_cast<i32>(t)));
+
+    // Radians in Q30 to turns in Q32 is a multiply by 2 / pi.
+    u32 theta = static_cast<u32>((u64(r.raw()) * two_by_pi + (u64(1) << 31)) >> 32);
+    if (steep)
+        theta = (u32(1) << 30) - theta;
+    if (x < 0)
+        theta = (u32(1) << 31) - theta;
+    if (y < 0)
+        theta = u32(0) - theta;
+    return theta;
+}
+
+}
+
+template<std::unsigned_integral base> requires (sizeof(base) == 2 || sizeof(base) == 4)
+class angle {
+    base _data;
+public:
+    using base_type = base;
+    static constexpr int bits = sizeof(base) * CHAR_BIT;
+
+    template<std::integral T>
+    static constexpr angle from_raw(T b) {
+        angle out;
+        out._data = static_cast<base>(b);
+        return out;
+    }
+
+    // The direction of (x, y), as atan2 gives it.
+    template<std::integral other_base, int fp>
+    static constexpr angle atan2(fixed<other_base, fp> y, fixed<other_base, fp> x) {
+        const u32 theta = impl::angle_atan2(y, x);
+        if constexpr(bits == 32)
+            return from_raw(theta);
+        else
+            return from_raw((theta + (u32(1) << 15)) >> 16);
+    }
+
+    constexpr angle() = default;
+
+    // From radians, wrapped to one turn. 1 / tau is held to 64 bits, so the
+    // wrap stays exact for any radians the format holds.
+    template<std::integral other_base, int fp, overflow_policy ovf, rounding_policy rnd>
+    constexpr explicit angle(fixed<other_base, fp, ovf, rnd> radians) {
+        constexpr int shift = fp + 64 - bits;
+        constexpr u64 inv_tau = impl::q126_bits<u64>(impl::two_by_pi_q126, 62); // 1 / tau in Q64
+        const i128 turns = static_cast<i128>(radians.raw()) * inv_tau;
+        _data = static_cast<base>((turns + (i128(1) << (shift - 1))) >> shift);
+    }
+
+    template<std::floating_point T>
+    constexpr explicit angle(T radians) {
+        const T turns = radians / T(6.2831853071795864769);
+        const T frac = turns - static_cast<T>(static_cast<i64>(turns));
+        const T scaled = frac * static_cast<T>(u64(1) << bits);
+        _data = static_cast<base>(static_cast<i64>(scaled + ((scaled < 0) ? T(-0.5) : T(0.5))));
+    }
+
+    constexpr base raw() const {
+        return _data;
+    }
+
+    // To radians in [-pi, pi).
+    template<std::integral other_base, int fp, overflow_policy ovf, rounding_policy rnd>
+    constexpr explicit operator fixed<other_base, fp, ovf, rnd>() const {
+        constexpr int shift = 60 + bits - fp;
+        constexpr u64 tau = impl::q126_bits<u64>(impl::half_pi_q126, 62); // tau in Q60
+        const i128 value = static_cast<i128>(static_cast<std::make_signed_t<base>>(_data)) * tau;
+        return fixed<other_base, fp, ovf, rnd>::from_raw(
+            impl::narrow<ovf, other_base>(static_cast<i64>((value + (i128(1) << (shift - 1))) >> shift)));
+    }
+
+    template<std::floating_point T>
+    constexpr explicit operator T() const {
+        return static_cast<T>(static_cast<std::make_signed_t<base>>(_data)) * T(6.2831853071795864769) / static_cast<T>(u64(1) << bits);
+    }
+
+    constexpr angle operator-() const { return from_raw(base(0) - _data); }
+
+    constexpr angle& operator+=(const angle other) { _data += other._data; return *this; }
+    constexpr angle& operator-=(const angle other) { _data -= other._data; return *this; }
+
+    template<std::integral T>
+    constexpr angle& operator*=(const T n) { _data = static_cast<base>(u32(_data) * static_cast<u32>(n)); return *this; }
+
+    constexpr friend angle operator+(angle a, const angle b) { return a += b; }
+    constexpr friend angle operator-(angle a, const angle b) { return a -= b; }
+
+    template<std::integral T>
+    constexpr friend angle operator*(angle a, const T n) { return a *= n; }
+
+    constexpr friend bool operator==(const angle a, const angle b) {
+        return a._data == b._data;
+    }
+};
+
+using angle16 = angle<u16>;
+using angle32 = angle<u32>;
+
+namespace impl {
+
+template<std::unsigned_integral base>
+constexpr u32 to_angle32(angle<base> a) {
+    return static_cast<u32>(a.raw()) << (32 - angle<base>::bits);
+}
+
+}
+
+// Trigonometry
+
+template<std::unsigned_integral base>
+constexpr trig_t sin(angle<base> a) {
+    trig_t s, c;
+    impl::angle_sincos(impl::to_angle32(a), s, c);
+    return s;
+}
+
+template<std::unsigned_integral base>
+constexpr trig_t cos(angle<base> a) {
+    trig_t s, c;
+    impl::angle_sincos(impl::to_angle32(a), s, c);
+    return c;
+}
+
+template<std::unsigned_integral base>
+constexpr void sincos(angle<base> a, trig_t& out_sin, trig_t& out_cos) {
+    impl::angle_sincos(impl::to_angle32(a), out_sin, out_cos);
+}
+
+namespace impl {
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+// angle_sincos on eight lanes, bit-identical to the scalar version.
+FXD_TARGET_AVX2 inline void angle_sincos(__m256i a, __m256i& out_sin, __m256i& out_cos) {
+    constexpr int f = trig_t::frac_bits;
+    const __m256i quadrant = _mm256_srli_epi32(a, 30);
+    const __m256i index = _mm256_and_si256(_mm256_srli_epi32(a, 23), set1(127));
+    const __m256i d = _mm256_srli_epi32(
+        mulu<32>(_mm256_and_si256(a, set1(0x7fffff)), set1(static_cast<i32>(half_pi_q31))), 2);
+
+    const __m256i d2 = mul<f>(d, d);
+    const __m256i sin_d = _mm256_sub_epi32(d, mul<f>(mul<f>(d, d2), set1(one_sixth.raw())));
+    const __m256i cos_d = _mm256_sub_epi32(set1(1 << f), _mm256_srai_epi32(d2, 1));
+    const __m256i s = gather(quarter_sin.data(), index);
+    const __m256i c = gather(quarter_sin.data(), _mm256_sub_epi32(set1(128), index));
+
+    const __m256i y_sin = _mm256_add_epi32(mul<f>(s, cos_d), mul<f>(c, sin_d));
+    const __m256i y_cos = _mm256_sub_epi32(mul<f>(c, cos_d), mul<f>(s, sin_d));
+
+    const __m256i odd = _mm256_cmpeq_epi32(_mm256_and_si256(quadrant, set1(1)), set1(1));
+    const __m256i sin_flip = _mm256_cmpeq_epi32(_mm256_and_si256(quadrant, set1(2)), set1(2));
+    const __m256i cos_flip = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, set1(1)), set1(2)), set1(2));
+
+    out_sin = negate_if(select(y_sin, y_cos, odd), sin_flip);
+    out_cos = negate_if(select(y_cos, y_sin, odd), cos_flip);
+}
+
+// Eight angles as angle32 lanes.
+template<std::unsigned_integral base>
+FXD_TARGET_AVX2 inline __m256i load_angles(const angle<base>* p) {
+    if constexpr(sizeof(base) == sizeof(u32))
+        return load(p);
+    else
+        return _mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))), 16);
+}
+
+template<std::unsigned_integral base, bool want_sin, bool want_cos>
+FXD_TARGET_AVX2 std::size_t angle_sincos(const angle<base>* in, trig_t* out_sin, trig_t* out_cos, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i s, c;
+        angle_sincos(load_angles(in + i), s, c);
+        if constexpr(want_sin) store(out_sin + i, s);
+        if constexpr(want_cos) store(out_cos + i, c);
+    }
+    return i;
+}
+
+// (a * b) >> shift on a 64-bit product, rounded half up, as fixed<i32, shift,
+// overflow::wrap, rounding::half_up> multiplies.
+template<int shift>
+FXD_TARGET_AVX2 inline __m256i mul_half_up(__m256i a, __m256i b) {
+    const __m256i half = _mm256_set1_epi64x(i64(1) << (shift - 1));
+    const __m256i even = _mm256_srli_epi64(_mm256_add_epi64(_mm256_mul_epi32(a, b), half), shift);
+    const __m256i odd  = _mm256_slli_epi64(_mm256_srli_epi64(_mm256_add_epi64(
+        _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), half), shift), 32);
+    return _mm256_blend_epi32(even, odd, 0xaa);
+}
+
+// u32 lanes to exact doubles.
+FXD_TARGET_AVX2 inline __m256d u32_to_pd(__m128i v) {
+    return _mm256_add_pd(_mm256_cvtepi32_pd(_mm_xor_si128(v, _mm_set1_epi32(INT32_MIN))), _mm256_set1_pd(2147483648.0));
+}
+
+// (lo << 30) / hi, truncated, on four u32 lanes with lo <= hi <= 2^31. The
+// double quotient can round up to the next integer, which multiplying back
+// catches.
+FXD_TARGET_AVX2 inline __m128i divide_q30(__m128i lo, __m128i hi) {
+    const __m256d q = _mm256_div_pd(_mm256_mul_pd(u32_to_pd(lo), _mm256_set1_pd(1073741824.0)), u32_to_pd(hi));
+    __m256i q64 = _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(q));
+    const __m256i n = _mm256_slli_epi64(_mm256_cvtepu32_epi64(lo), 30);
+    const __m256i over = _mm256_cmpgt_epi64(_mm256_mul_epu32(q64, _mm256_cvtepu32_epi64(hi)), n);
+    q64 = _mm256_add_epi64(q64, over);
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(q64, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+}
+
+// angle_atan2 on eight lanes, bit-identical to the scalar version.
+FXD_TARGET_AVX2 inline __m256i angle_atan2(__m256i y, __m256i x) {
+    constexpr auto c = coefficients<atan2_work_t>(atan_poly19);
+    const __m256i ax = _mm256_abs_epi32(x);
+    const __m256i ay = _mm256_abs_epi32(y);
+    const __m256i hi = _mm256_max_epu32(ax, ay);
+    const __m256i lo = _mm256_min_epu32(ax, ay);
+    const __m256i steep = _mm256_xor_si256(_mm256_cmpeq_epi32(hi, ax), set1(-1));
+
+    const __m128i t_low = divide_q30(_mm256_castsi256_si128(lo), _mm256_castsi256_si128(hi));
+    const __m128i t_high = divide_q30(_mm256_extracti128_si256(lo, 1), _mm256_extracti128_si256(hi, 1));
+    const __m256i t = _mm256_inserti128_si256(_mm256_castsi128_si256(t_low), t_high, 1);
+
+    // fast_atan<30>, which takes the 19th-order polynomial.
+    const __m256i t2 = mul_half_up<30>(t, t);
+    __m256i r = set1(c[c.size() - 1].raw());
+    for (std::size_t i = c.size() - 1; i-- > 0;)
+        r = _mm256_add_epi32(mul_half_up<30>(r, t2), set1(c[i].raw()));
+    r = mul_half_up<30>(t, r);
+
+    const __m256i half = _mm256_set1_epi64x(i64(1) << 31);
+    const __m256i scale = _mm256_set1_epi64x(static_cast<i64>(two_by_pi_q32));
+    const __m256i even = _mm256_srli_epi64(_mm256_add_epi64(_mm256_mul_epu32(r, scale), half), 32);
+    const __m256i odd = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(r, 32), scale), half);
+    __m256i theta = _mm256_blend_epi32(even, odd, 0xaa);
+
+    theta = select(theta, _mm256_sub_epi32(set1(1 << 30), theta), steep);
+    theta = select(theta, _mm256_sub_epi32(set1(INT32_MIN), theta), _mm256_cmpgt_epi32(_mm256_setzero_si256(), x));
+    theta = negate_if(theta, _mm256_cmpgt_epi32(_mm256_setzero_si256(), y));
+    return _mm256_andnot_si256(_mm256_cmpeq_epi32(hi, _mm256_setzero_si256()), theta);
+}
+
+template<std::unsigned_integral base, int fp>
+FXD_TARGET_AVX2 std::size_t angle_atan2(const fixed<i32, fp>* y, const fixed<i32, fp>* x, angle<base>* out, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i theta = angle_atan2(load(y + i), load(x + i));
+        if constexpr(sizeof(base) == sizeof(u32)) {
+            store(out + i, theta);
+        }
+        else {
+            // The top 16 bits, rounded, with the carry out of bit 31 dropped.
+            const __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(theta, set1(1 << 15)), 16);
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded, rounded), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+        }
+    }
+    return i;
+}
+
+}
+#endif
+
+template<bool want_sin, bool want_cos, std::unsigned_integral base>
+std::size_t angle_sincos_kernel(std::span<const angle<base>> in, trig_t* out_sin, trig_t* out_cos) {
+#ifdef FXD_X86_SIMD
+    if (has_avx2())
+        return avx2::angle_sincos<base, want_sin, want_cos>(in.data(), out_sin, out_cos, in.size());
+#endif
+    return 0;
+}
+
+}
+
+// Outputs must be at least as long as the inputs.
+
+template<std::unsigned_integral base>
+void sincos(std::span<const angle<base>> in, std::span<trig_t> out_sin, std::span<trig_t> out_cos) {
+    std::size_t i = impl::angle_sincos_kernel<true, true>(in, out_sin.data(), out_cos.data());
+    for (; i < in.size(); i++)
+        sincos(in[i], out_sin[i], out_cos[i]);
+}
+
+template<std::unsigned_integral base>
+void sin(std::span<const angle<base>> in, std::span<trig_t> out) {
+    std::size_t i = impl::angle_sincos_kernel<true, false>(in, out.data(), nullptr);
+    for (; i < in.size(); i++)
+        out[i] = sin(in[i]);
+}
+
+template<std::unsigned_integral base>
+void cos(std::span<const angle<base>> in, std::span<trig_t> out) {
+    std::size_t i = impl::angle_sincos_kernel<false, true>(in, nullptr, out.data());
+    for (; i < in.size(); i++)
+        out[i] = cos(in[i]);
+}
+
+template<std::unsigned_integral base, std::integral other_base, int fp>
+void atan2(std::span<const fixed<other_base, fp>> y, std::span<const fixed<other_base, fp>> x, std::span<angle<base>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<other_base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::angle_atan2<base, fp>(y.data(), x.data(), out.data(), y.size());
+#endif
+    for (; i < y.size(); i++)
+        out[i] = angle<base>::atan2(y[i], x[i]);
+}
+
+}
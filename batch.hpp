@@ -0,0 +1,632 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./math.hpp"
+#include "./simd.hpp"
+
+// Span versions of the functions in math.hpp.
+// Outputs must be at least as long as the input, and results are
+// bit-identical to calling the scalar function on each element.
+
+namespace fxd {
+
+namespace impl {
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+FXD_TARGET_AVX2 inline __m256i get_cos(__m256i x) {
+    constexpr int f = trig_t::frac_bits;
+    const __m256i x2 = mul<f>(x, x);
+    const __m256i x4 = mul<f>(x2, x2);
+    const __m256i x6 = mul<f>(x4, x2);
+
+    __m256i y = _mm256_sub_epi32(set1(trig_t(1).raw()), _mm256_srai_epi32(x2, 1));
+    y = _mm256_add_epi32(y, mul<f>(x4, set1(cos_c1.raw())));
+    y = _mm256_sub_epi32(y, mul<f>(x6, set1(cos_c2.raw())));
+    y = _mm256_add_epi32(y, mul<f>(mul<f>(x6, x2), set1(cos_c3.raw())));
+    return y;
+}
+
+FXD_TARGET_AVX2 inline __m256i get_sin(__m256i x) {
+    constexpr int f = trig_t::frac_bits;
+    const __m256i x2 = mul<f>(x, x);
+    const __m256i x3 = mul<f>(x2, x);
+    const __m256i x5 = mul<f>(x3, x2);
+
+    __m256i y = _mm256_sub_epi32(x, mul<f>(x3, set1(sin_c1.raw())));
+    y = _mm256_add_epi32(y, mul<f>(x5, set1(sin_c2.raw())));
+    y = _mm256_sub_epi32(y, mul<f>(mul<f>(x5, x2), set1(sin_c3.raw())));
+    return y;
+}
+
+// One Newton step towards 1/sqrt(x), as in rsqrt: y * (1.5 - x * y * y).
+FXD_TARGET_AVX2 inline __m256i rsqrt_step(__m256i x, __m256i y) {
+    constexpr int h = high_t::frac_bits;
+    const __m256i xyy = mul<h>(mul<h>(x, y), y);
+    return mul<h>(y, _mm256_sub_epi32(set1(high_t(1.5).raw()), xyy));
+}
+
+// One Newton step towards 1/x, as in rcp: y * (2 - x * y).
+FXD_TARGET_AVX2 inline __m256i rcp_step(__m256i x, __m256i y) {
+    constexpr int h = high_t::frac_bits;
+    return mul<h>(y, _mm256_sub_epi32(set1(high_t(2).raw()), mul<h>(x, y)));
+}
+
+// Shared front end of sqrt and rsqrt: normalizes s to x in [0.5, 1) as high_t,
+// and refines the table estimate of 1/sqrt(x).
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i rsqrt_core(__m256i s, __m256i log2, __m256i& x) {
+    constexpr int h = high_t::frac_bits;
+    x = convert<fp, h>(_mm256_srai_epi32(shift_right(s, log2), 1));
+
+    const __m256i idx = _mm256_srli_epi32(_mm256_and_si256(x, set1(0xfe << 17)), 18);
+    __m256i y = _mm256_srli_epi32(gather(rsqrt_lut.data(), idx), 5);
+    y = rsqrt_step(x, y);
+    y = rsqrt_step(x, y);
+    return y;
+}
+
+// log2 / 2 rounded towards zero, the halving both sqrt and rsqrt use.
+FXD_TARGET_AVX2 inline __m256i half_log2(__m256i log2) {
+    return _mm256_srai_epi32(_mm256_add_epi32(log2, _mm256_srli_epi32(log2, 31)), 1);
+}
+
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i sqrt(__m256i s) {
+    constexpr int h = high_t::frac_bits;
+    const __m256i log2 = _mm256_sub_epi32(ilog2(s), set1(fp));
+    const __m256i positive = _mm256_cmpgt_epi32(log2, _mm256_setzero_si256());
+    const __m256i odd = _mm256_srai_epi32(_mm256_slli_epi32(log2, 31), 31);
+
+    __m256i x;
+    __m256i y = rsqrt_core<fp>(s, log2, x);
+    y = mul<h>(y, _mm256_slli_epi32(x, 1));
+
+    const __m256i factor = select(set1(rsqrt_2<high_t>.raw()), set1(sqrt_2<high_t>.raw()), positive);
+    y = select(y, mul<h>(y, factor), odd);
+
+    const __m256i k = half_log2(log2);
+    const __m256i out = shift_right(convert<h, fp>(y), _mm256_sub_epi32(_mm256_setzero_si256(), k));
+    return _mm256_andnot_si256(_mm256_cmpgt_epi32(set1(1), s), out);
+}
+
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i rsqrt(__m256i s) {
+    constexpr int h = high_t::frac_bits;
+    const __m256i log2 = _mm256_sub_epi32(ilog2(s), set1(fp));
+    const __m256i positive = _mm256_cmpgt_epi32(log2, _mm256_setzero_si256());
+    const __m256i odd = _mm256_srai_epi32(_mm256_slli_epi32(log2, 31), 31);
+
+    __m256i x;
+    __m256i y = rsqrt_core<fp>(s, log2, x);
+
+    const __m256i factor = select(set1(sqrt_2<high_t>.raw()), set1(rsqrt_2<high_t>.raw()), positive);
+    y = select(y, mul<h>(y, factor), odd);
+
+    const __m256i out = shift_right(convert<h, fp>(y), half_log2(log2));
+    return _mm256_andnot_si256(_mm256_cmpgt_epi32(set1(1), s), out);
+}
+
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i rcp(__m256i s) {
+    constexpr int h = high_t::frac_bits;
+    const __m256i negative = _mm256_cmpgt_epi32(_mm256_setzero_si256(), s);
+    const __m256i zero = _mm256_cmpeq_epi32(s, _mm256_setzero_si256());
+    s = _mm256_abs_epi32(s);
+
+    const __m256i log2 = _mm256_sub_epi32(ilog2(s), set1(fp));
+    const __m256i x = convert<fp, h>(shift_right(s, log2));
+    const __m256i idx = _mm256_srli_epi32(_mm256_and_si256(x, set1(0xfe << 18)), 19);
+
+    __m256i y = _mm256_srli_epi32(gather(rcp_lut.data(), idx), 5);
+    y = rcp_step(x, y);
+    y = rcp_step(x, y);
+
+    const __m256i out = negate_if(shift_right(convert<h, fp>(y), log2), negative);
+    return select(out, set1(fixed<i32, fp>::max().raw()), zero);
+}
+
+// impl::reduce_half_pi on four 64-bit lanes, for u = |s| in the low words.
+// The remainder comes back in the high words and q in the low words.
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i reduce_half_pi(__m256i u, __m256i& q) {
+    constexpr int f = trig_t::frac_bits;
+    constexpr u64 two_by_pi = q126_bits<u64>(two_by_pi_q126, 32);
+    constexpr u128 half_pi_all = q126_bits<u128>(half_pi_q126, f + 64);
+
+    q = _mm256_srli_epi64(_mm256_add_epi64(_mm256_mul_epu32(u, _mm256_set1_epi64x(two_by_pi)),
+                                           _mm256_set1_epi64x(i64(1) << (31 + fp))), 32 + fp);
+
+    __m256i x;
+    if constexpr(fp > f)
+        x = _mm256_srli_epi64(_mm256_add_epi64(u, _mm256_set1_epi64x(i64(1) << (fp - f - 1))), fp - f);
+    else
+        x = _mm256_slli_epi64(u, f - fp);
+
+    const __m256i q_hi = _mm256_mul_epu32(q, _mm256_set1_epi64x(static_cast<i64>(half_pi_all >> 64)));
+    const __m256i q_mid = _mm256_mul_epu32(q, _mm256_set1_epi64x(static_cast<i64>((half_pi_all >> 32) & 0xffffffff)));
+    const __m256i q_lo = _mm256_mul_epu32(q, _mm256_set1_epi64x(static_cast<i64>(half_pi_all & 0xffffffff)));
+    const __m256i r = _mm256_sub_epi64(_mm256_slli_epi64(_mm256_sub_epi64(x, q_hi), 32), q_mid);
+    const __m256i low = _mm256_srli_epi64(_mm256_add_epi64(q_lo, _mm256_set1_epi64x(0xffffffff)), 32);
+    return _mm256_sub_epi64(_mm256_add_epi64(r, _mm256_set1_epi64x(i64(1) << 31)), low);
+}
+
+// impl::reduce_half_pi on eight lanes of s: the remainder in trig_t, and
+// the quadrant.
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i reduce_quadrant(__m256i s, __m256i& quadrant) {
+    // |min| is 2^31 in the unsigned view the reduction takes.
+    const __m256i u = _mm256_abs_epi32(s);
+
+    __m256i q_even, q_odd;
+    const __m256i r_even = reduce_half_pi<fp>(_mm256_and_si256(u, _mm256_set1_epi64x(0xffffffff)), q_even);
+    const __m256i r_odd = reduce_half_pi<fp>(_mm256_srli_epi64(u, 32), q_odd);
+    quadrant = _mm256_and_si256(_mm256_blend_epi32(q_even, _mm256_slli_epi64(q_odd, 32), 0xaa), set1(3));
+    return _mm256_blend_epi32(_mm256_srli_epi64(r_even, 32), r_odd, 0xaa);
+}
+
+// Moves sin and cos of the remainder into the quadrant of s, as the scalar
+// sincos does, with the sign branches turned into masks.
+FXD_TARGET_AVX2 inline void unfold_quadrant(__m256i s, __m256i quadrant, __m256i sn, __m256i c,
+                                            __m256i& out_sin, __m256i& out_cos) {
+    const __m256i negative = _mm256_cmpgt_epi32(_mm256_setzero_si256(), s);
+    const __m256i odd = _mm256_cmpeq_epi32(_mm256_and_si256(quadrant, set1(1)), set1(1));
+    const __m256i cos_flip = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, set1(1)), set1(2)), set1(2));
+    const __m256i sin_flip = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, set1(2)), set1(2)), negative);
+
+    out_cos = negate_if(select(c, sn, odd), cos_flip);
+    out_sin = negate_if(select(sn, c, odd), sin_flip);
+}
+
+template<int fp>
+FXD_TARGET_AVX2 inline void sincos(__m256i s, __m256i& out_sin, __m256i& out_cos) {
+    __m256i quadrant;
+    const __m256i x = reduce_quadrant<fp>(s, quadrant);
+    unfold_quadrant(s, quadrant, get_sin(x), get_cos(x), out_sin, out_cos);
+}
+
+// Returns how many elements were processed; the caller finishes the tail.
+template<int fp, bool want_sin, bool want_cos>
+FXD_TARGET_AVX2 std::size_t sincos(const fixed<i32, fp>* in, trig_t* out_sin, trig_t* out_cos, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i s, c;
+        sincos<fp>(load(in + i), s, c);
+        if constexpr(want_sin) store(out_sin + i, s);
+        if constexpr(want_cos) store(out_cos + i, c);
+    }
+    return i;
+}
+
+FXD_TARGET_AVX2 inline __m256i atan01(__m256i x) {
+    constexpr int f = trig_t::frac_bits;
+    const __m256i x2 = mul<f>(x, x);
+
+    __m256i low = _mm256_sub_epi32(set1(atan_c3.raw()), mul<f>(x2, set1(atan_c4.raw())));
+    low = _mm256_sub_epi32(set1(atan_c2.raw()), mul<f>(x2, low));
+    low = _mm256_sub_epi32(set1(atan_c1.raw()), mul<f>(x2, low));
+    low = mul<f>(x, _mm256_sub_epi32(set1(trig_t(1).raw()), mul<f>(x2, low)));
+
+    __m256i high = _mm256_add_epi32(mul<f>(set1(atan_c5.raw()), x), set1(atan_c6.raw()));
+    high = _mm256_add_epi32(mul<f>(x, high), set1(atan_c7.raw()));
+    high = _mm256_add_epi32(mul<f>(x, high), set1(atan_c8.raw()));
+    high = _mm256_add_epi32(mul<f>(x, high), set1(atan_c9.raw()));
+    high = _mm256_add_epi32(mul<f>(x, high), set1(atan_c10.raw()));
+
+    return select(high, low, less_equal(x, set1(trig_t(0.375).raw())));
+}
+
+// trunc(lo / hi) in trig_t on four lanes, for lo <= hi < 2^25.
+FXD_TARGET_AVX2 inline __m128i divide_trig(__m128i lo, __m128i hi) {
+    const __m256d one = _mm256_set1_pd(double(trig_t(1).raw()));
+    return _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(lo), one), _mm256_cvtepi32_pd(hi)));
+}
+
+// impl::octant_ratio on u32 lanes. Lanes where hi is zero come back as garbage.
+FXD_TARGET_AVX2 inline __m256i octant_ratio(__m256i lo, __m256i hi) {
+    // ilog2(hi) - 24, taken on hi >> 1 because hi can be 2^31.
+    const __m256i k = _mm256_max_epi32(_mm256_sub_epi32(ilog2(_mm256_srli_epi32(hi, 1)), set1(23)),
+                                       _mm256_setzero_si256());
+    lo = _mm256_srlv_epi32(lo, k);
+    hi = _mm256_srlv_epi32(hi, k);
+
+    const __m128i low = divide_trig(_mm256_castsi256_si128(lo), _mm256_castsi256_si128(hi));
+    const __m128i high = divide_trig(_mm256_extracti128_si256(lo, 1), _mm256_extracti128_si256(hi, 1));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+// The octant unfolding of the scalar atan2, as masks.
+FXD_TARGET_AVX2 inline __m256i unfold_octant(__m256i a, __m256i x, __m256i y, __m256i steep) {
+    a = select(a, _mm256_sub_epi32(set1(half_pi<trig_t>.raw()), a), steep);
+    a = select(a, _mm256_sub_epi32(set1(pi<trig_t>.raw()), a), _mm256_cmpgt_epi32(_mm256_setzero_si256(), x));
+    return negate_if(a, _mm256_cmpgt_epi32(_mm256_setzero_si256(), y));
+}
+
+template<int fp, bool want_r>
+FXD_TARGET_AVX2 std::size_t to_polar(const fixed<i32, fp>* x, const fixed<i32, fp>* y,
+                                     fixed<i32, fp>* out_r, trig_t* out_theta, std::size_t n) {
+    constexpr int f = trig_t::frac_bits;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i vx = load(x + i);
+        const __m256i vy = load(y + i);
+        const __m256i ax = _mm256_abs_epi32(vx);
+        const __m256i ay = _mm256_abs_epi32(vy);
+        const __m256i hi = _mm256_max_epu32(ax, ay);
+        const __m256i zero = _mm256_cmpeq_epi32(hi, _mm256_setzero_si256());
+        const __m256i steep = _mm256_xor_si256(_mm256_cmpeq_epi32(hi, ax), set1(-1));
+        const __m256i t = octant_ratio(_mm256_min_epu32(ax, ay), hi);
+
+        if constexpr(want_r) {
+            const __m256i scale = sqrt<f>(_mm256_add_epi32(set1(trig_t(1).raw()), mul<f>(t, t)));
+            store(out_r + i, _mm256_andnot_si256(zero, mulu<f>(hi, scale)));
+        }
+        store(out_theta + i, _mm256_andnot_si256(zero, unfold_octant(atan01(t), vx, vy, steep)));
+    }
+    return i;
+}
+
+template<int fp>
+FXD_TARGET_AVX2 std::size_t from_polar(const fixed<i32, fp>* r, const trig_t* theta,
+                                       fixed<i32, fp>* out_x, fixed<i32, fp>* out_y, std::size_t n) {
+    constexpr int f = trig_t::frac_bits;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i s, c;
+        sincos<f>(load(theta + i), s, c);
+        const __m256i vr = load(r + i);
+        store(out_x + i, mul<f>(vr, c));
+        store(out_y + i, mul<f>(vr, s));
+    }
+    return i;
+}
+
+// The scalar exp2 polynomial, on x: (-1, 1) in exp_t.
+FXD_TARGET_AVX2 inline __m256i exp2_approx(__m256i x) {
+    constexpr int f = exp_t::frac_bits;
+    const __m256i one = set1(exp_t(1).raw());
+    x = mul<f>(x, set1(ln2<exp_t>.raw()));
+
+    __m256i y = _mm256_add_epi32(one, mul<f>(x, set1(exp2_c2.raw())));
+    y = _mm256_add_epi32(one, mul<f>(_mm256_srai_epi32(x, 2), y));
+    y = _mm256_add_epi32(one, mul<f>(mul<f>(x, set1(exp2_c1.raw())), y));
+    y = _mm256_add_epi32(one, mul<f>(_mm256_srai_epi32(x, 1), y));
+    return _mm256_add_epi32(one, mul<f>(x, y));
+}
+
+// exp2(s, multiplier) for a positive multiplier given as exp_t raw. The
+// product is split on 64-bit lanes like the scalar one, and the saturated
+// lanes are blended in at the end, so there are no branches.
+template<int fp, i32 multiplier>
+FXD_TARGET_AVX2 inline __m256i exp2(__m256i s) {
+    using fixed_t = fixed<i32, fp>;
+    constexpr int f = exp_t::frac_bits;
+    static_assert(multiplier > 0);
+
+    // The scalar bounds on s * multiplier, as bounds on s.
+    constexpr auto floor_div = [] (i64 a, i64 b) { return a / b - ((a % b != 0) && (a < 0)); };
+    constexpr i64 max_p = i64(fixed_t(fxd::log2(fixed_t::max())).raw()) << f;
+    constexpr i64 min_p = i64(get_min_exp2_input<i32, fp>().raw()) << f;
+    constexpr i64 above = std::min<i64>(-floor_div(-max_p, multiplier) - 1, INT32_MAX);
+    constexpr i64 below = std::max<i64>(floor_div(min_p, multiplier) + 1, INT32_MIN);
+
+    const __m256i negative = _mm256_cmpgt_epi32(_mm256_setzero_si256(), s);
+    const __m256i u = _mm256_abs_epi32(s);
+    const __m256i m = _mm256_set1_epi64x(multiplier);
+    const __m256i p_even = _mm256_mul_epu32(u, m);
+    const __m256i p_odd = _mm256_mul_epu32(_mm256_srli_epi64(u, 32), m);
+
+    // |p| = n + x, with n whole and x: [0, 1) in exp_t.
+    const __m256i n = _mm256_blend_epi32(_mm256_srli_epi64(p_even, fp + f),
+                                         _mm256_slli_epi64(_mm256_srli_epi64(p_odd, fp + f), 32), 0xaa);
+    const __m256i x = _mm256_and_si256(set1((1 << f) - 1),
+        _mm256_blend_epi32(_mm256_srli_epi64(p_even, fp), _mm256_slli_epi64(_mm256_srli_epi64(p_odd, fp), 32), 0xaa));
+
+    const __m256i one = set1(fixed_t(1).raw());
+    const __m256i y = convert<f, fp>(exp2_approx(negate_if(x, negative)));
+    const __m256i scale = select(_mm256_sllv_epi32(one, n), _mm256_srav_epi32(one, n), negative);
+
+    __m256i out = mul<fp>(scale, y);
+    out = select(out, set1(fixed_t::min_frac().raw()), _mm256_cmpgt_epi32(set1(i32(below)), s));
+    out = select(out, set1(fixed_t::max().raw()), _mm256_cmpgt_epi32(s, set1(i32(above))));
+    return select(out, one, _mm256_cmpeq_epi32(s, _mm256_setzero_si256()));
+}
+
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i exp(__m256i s) {
+    return exp2<fp, log2e<exp_t>.raw()>(s);
+}
+
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i exp10(__m256i s) {
+    return exp2<fp, log2_10<exp_t>.raw()>(s);
+}
+
+// Same steps as the scalar log2, with exp_t::min() blended into lanes <= 0.
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i log2(__m256i s) {
+    constexpr int l = log_t::frac_bits;
+    constexpr int f = exp_t::frac_bits;
+    const __m256i e = _mm256_sub_epi32(ilog2(s), set1(fp));
+    const __m256i x = convert<fp, l>(shift_right(s, e));
+
+    // log2_sqrt
+    const __m256i half = _mm256_srai_epi32(x, 1);
+    const __m256i idx = _mm256_and_si256(_mm256_srai_epi32(half, l - 1 - 7), set1(127));
+    __m256i y = _mm256_srli_epi32(gather(rsqrt_lut.data(), idx), 4);
+    for (int i = 0; i < 2; i++)
+        y = mul<l>(y, _mm256_sub_epi32(set1(log_t(1.5).raw()), mul<l>(mul<l>(half, y), y)));
+    y = mul<l>(y, x);
+
+    __m256i p = _mm256_add_epi32(mul<l>(set1(log2_c1.raw()), y), set1(log2_c2.raw()));
+    p = _mm256_add_epi32(mul<l>(y, p), set1(log2_c3.raw()));
+    p = _mm256_add_epi32(mul<l>(y, p), set1(log2_c4.raw()));
+    p = _mm256_add_epi32(mul<l>(y, p), set1(log2_c5.raw()));
+    p = _mm256_add_epi32(mul<l>(y, p), set1(log2_c6.raw()));
+
+    // (p << 1) to exp_t rounds towards zero.
+    p = _mm256_slli_epi32(p, 1);
+    p = _mm256_srai_epi32(_mm256_add_epi32(p, _mm256_srli_epi32(p, 31)), l - f);
+
+    const __m256i out = _mm256_add_epi32(_mm256_slli_epi32(e, f), p);
+    return select(out, set1(exp_t::min().raw()), _mm256_cmpgt_epi32(set1(1), s));
+}
+
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i log(__m256i s) {
+    return mul<exp_t::frac_bits>(log2<fp>(s), set1(ln2<exp_t>.raw()));
+}
+
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i log10(__m256i s) {
+    return mul<exp_t::frac_bits>(log2<fp>(s), set1(log10_2<exp_t>.raw()));
+}
+
+// pow for one exponent y, so its parity and integer test are uniform.
+template<int fp>
+FXD_TARGET_AVX2 std::size_t pow(const fixed<i32, fp>* in, exp_t y, fixed<i32, fp>* out, std::size_t n) {
+    constexpr int f = exp_t::frac_bits;
+    const bool integral = y.frac() == 0;
+    const __m256i odd = set1((integral && (int(y) & 1)) ? -1 : 0);
+    const __m256i not_real = set1(integral ? 0 : -1);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = load(in + i);
+        const __m256i negative = _mm256_cmpgt_epi32(_mm256_setzero_si256(), x);
+        const __m256i e = mul<f>(set1(y.raw()), log2<fp>(_mm256_abs_epi32(x)));
+
+        __m256i r = convert<f, fp>(exp2<f, exp_t(1).raw()>(e));
+        r = negate_if(r, _mm256_and_si256(negative, odd));
+        r = select(r, set1(fixed<i32, fp>::min().raw()), _mm256_and_si256(negative, not_real));
+        store(out + i, _mm256_andnot_si256(_mm256_cmpeq_epi32(x, _mm256_setzero_si256()), r));
+    }
+    return i;
+}
+
+}
+#endif
+
+template<bool want_sin, bool want_cos, std::integral base, int fp>
+std::size_t sincos_kernel(std::span<const fixed<base, fp>> in, trig_t* out_sin, trig_t* out_cos) {
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>) {
+        if (has_avx2())
+            return avx2::sincos<fp, want_sin, want_cos>(in.data(), out_sin, out_cos, in.size());
+    }
+#endif
+    return 0;
+}
+
+// out_r may be null when want_r is false.
+template<bool want_r, std::integral base, int fp>
+std::size_t to_polar_kernel(std::span<const fixed<base, fp>> x, std::span<const fixed<base, fp>> y,
+                            std::type_identity_t<fixed<base, fp>>* out_r, trig_t* out_theta) {
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>) {
+        if (has_avx2())
+            return avx2::to_polar<fp, want_r>(x.data(), y.data(), out_r, out_theta, x.size());
+    }
+#endif
+    return 0;
+}
+
+}
+
+// Exponents
+
+template<std::integral base, int fp>
+void sqrt(std::span<const fixed<base, fp>> in, std::span<fixed<base, fp>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::sqrt<fp>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = sqrt(in[i]);
+}
+
+template<std::integral base, int fp>
+void rsqrt(std::span<const fixed<base, fp>> in, std::span<fixed<base, fp>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::rsqrt<fp>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = rsqrt(in[i]);
+}
+
+template<std::integral base, int fp>
+void rcp(std::span<const fixed<base, fp>> in, std::span<fixed<base, fp>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::rcp<fp>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = rcp(in[i]);
+}
+
+// Trigonometry
+
+template<std::integral base, int fp>
+void sincos(std::span<const fixed<base, fp>> in, std::span<trig_t> out_sin, std::span<trig_t> out_cos) {
+    static_assert(fixed<base, fp>::is_signed, "sincos only supports signed fixed types!");
+
+    std::size_t i = impl::sincos_kernel<true, true>(in, out_sin.data(), out_cos.data());
+    for (; i < in.size(); i++)
+        sincos(in[i], out_sin[i], out_cos[i]);
+}
+
+template<std::integral base, int fp>
+void sin(std::span<const fixed<base, fp>> in, std::span<trig_t> out) {
+    static_assert(fixed<base, fp>::is_signed, "sin only supports signed fixed types!");
+
+    std::size_t i = impl::sincos_kernel<true, false>(in, out.data(), nullptr);
+    for (; i < in.size(); i++)
+        out[i] = sin(in[i]);
+}
+
+template<std::integral base, int fp>
+void cos(std::span<const fixed<base, fp>> in, std::span<trig_t> out) {
+    static_assert(fixed<base, fp>::is_signed, "cos only supports signed fixed types!");
+
+    std::size_t i = impl::sincos_kernel<false, true>(in, nullptr, out.data());
+    for (; i < in.size(); i++)
+        out[i] = cos(in[i]);
+}
+
+// Inverse Trigonometry
+
+template<std::integral base, int fp>
+void atan2(std::span<const fixed<base, fp>> y, std::span<const fixed<base, fp>> x, std::span<trig_t> out) {
+    std::size_t i = impl::to_polar_kernel<false>(x, y, nullptr, out.data());
+    for (; i < x.size(); i++)
+        out[i] = atan2(y[i], x[i]);
+}
+
+// Polar coordinates
+
+template<std::integral base, int fp>
+void to_polar(std::span<const fixed<base, fp>> x, std::span<const fixed<base, fp>> y,
+              std::span<fixed<base, fp>> out_r, std::span<trig_t> out_theta) {
+    std::size_t i = impl::to_polar_kernel<true>(x, y, out_r.data(), out_theta.data());
+    for (; i < x.size(); i++)
+        to_polar(x[i], y[i], out_r[i], out_theta[i]);
+}
+
+template<std::integral base, int fp>
+void from_polar(std::span<const fixed<base, fp>> r, std::span<const trig_t> theta,
+                std::span<fixed<base, fp>> out_x, std::span<fixed<base, fp>> out_y) {
+    static_assert(fixed<base, fp>::is_signed, "from_polar only supports signed fixed types!");
+
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::from_polar<fp>(r.data(), theta.data(), out_x.data(), out_y.data(), r.size());
+#endif
+    for (; i < r.size(); i++)
+        from_polar(r[i], theta[i], out_x[i], out_y[i]);
+}
+
+// Logarithms
+
+template<std::integral base, int fp>
+void log2(std::span<const fixed<base, fp>> in, std::span<impl::exp_result_t<base>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::log2<fp>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = log2(in[i]);
+}
+
+template<std::integral base, int fp>
+void log(std::span<const fixed<base, fp>> in, std::span<impl::exp_result_t<base>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::log<fp>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = log(in[i]);
+}
+
+template<std::integral base, int fp>
+void log10(std::span<const fixed<base, fp>> in, std::span<impl::exp_result_t<base>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::log10<fp>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = log10(in[i]);
+}
+
+// Powers
+
+template<std::integral base, int fp>
+void exp2(std::span<const fixed<base, fp>> in, std::span<fixed<base, fp>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::exp2<fp, exp_t(1).raw()>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = exp2(in[i]);
+}
+
+template<std::integral base, int fp>
+void exp(std::span<const fixed<base, fp>> in, std::span<fixed<base, fp>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::exp<fp>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = exp(in[i]);
+}
+
+template<std::integral base, int fp>
+void exp10(std::span<const fixed<base, fp>> in, std::span<fixed<base, fp>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::exp10<fp>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = exp10(in[i]);
+}
+
+template<std::integral base, int fp>
+void pow(std::span<const fixed<base, fp>> in, exp_t y, std::span<fixed<base, fp>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::pow<fp>(in.data(), y, out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = pow(in[i], y);
+}
+
+}
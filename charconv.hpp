@@ -0,0 +1,606 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <system_error>
+#include <type_traits>
+
+#if __has_include(<format>)
+    #include <format>
+#endif
+
+#include "./fixed.hpp"
+#include "./simd.hpp"
+
+// Decimal text for fixed values, in integer arithmetic only.
+//
+// Every fixed value has a finite decimal expansion of at most frac_bits
+// fraction digits, since 2^-fp = 5^fp / 10^fp. to_chars writes either
+//  - the shortest digits that lie strictly within half a step of the value,
+//    so reading them back with rounding to nearest gives the same bits, or
+//  - exactly `precision` fraction digits, rounded half to even from the
+//    exact expansion, like printf's %.*f.
+// Fraction digits come from multiplying the remainder by ten, in a word
+// twice the base's width at most, and nothing allocates.
+//
+// from_chars reads the same fixed notation straight into the raw value,
+// rounded to nearest with ties to even whatever the type's rounding policy,
+// so to_chars output always reads back to the same bits. Values out of
+// range report result_out_of_range, also whatever the overflow policy, and
+// leave the destination as it was, like std::from_chars. The span overload
+// parses comma or newline separated columns. With AVX2 it finds each
+// number's digits with one compare over 32 bytes and converts up to 16
+// digits at a time with multiply-adds.
+
+namespace fxd {
+
+namespace impl {
+
+// |value| split into its integer part and fraction digits.
+template<std::unsigned_integral U>
+struct decimal {
+    static constexpr int max_digits = std::numeric_limits<U>::digits;
+
+    U integer = 0;
+    std::array<char, max_digits> digits;
+    int count = 0;  // Fraction digits stored in digits
+    int zeros = 0;  // Fraction zeros after them, for precision beyond fp
+    bool negative = false;
+
+    // Adds one unit in the last stored digit.
+    constexpr void round_up() {
+        int i = count - 1;
+        for (; i >= 0 && digits[i] == '9'; i--)
+            digits[i] = '0';
+        if (i >= 0)
+            digits[i]++;
+        else
+            integer++;
+    }
+
+    constexpr int integer_length() const {
+        int n = 1;
+        for (U v = integer; v >= 10; v /= 10)
+            n++;
+        return n;
+    }
+
+    constexpr std::size_t size() const {
+        const int fraction = count + zeros;
+        return std::size_t(negative) + std::size_t(integer_length()) + (fraction > 0 ? std::size_t(fraction) + 1 : 0);
+    }
+
+    template<typename Out>
+    Out write(Out out) const {
+        if (negative)
+            *out++ = '-';
+
+        char buffer[std::numeric_limits<U>::digits10 + 1];
+        const auto end = std::to_chars(buffer, buffer + sizeof(buffer), integer).ptr;
+        out = std::copy(buffer, end, out);
+
+        if (count + zeros > 0) {
+            *out++ = '.';
+            out = std::copy(digits.begin(), digits.begin() + count, out);
+            out = std::fill_n(out, zeros, '0');
+        }
+        return out;
+    }
+};
+
+// The digits of value, shortest when precision is negative.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+constexpr auto to_decimal(fixed<base, fp, ovf, rnd> value, int precision) {
+    using ut = std::make_unsigned_t<base>;
+    using wide_t = std::conditional_t<(sizeof(base) <= sizeof(u32)), u64, u128>;
+    constexpr ut mask = (ut(1) << fp) - 1;
+
+    const ut raw = static_cast<ut>(value.raw());
+    decimal<ut> out;
+    if constexpr(std::is_signed_v<base>)
+        out.negative = value.raw() < 0;
+    const ut magnitude = out.negative ? static_cast<ut>(ut(0) - raw) : raw;
+    out.integer = static_cast<ut>(magnitude >> fp);
+    const ut fraction = magnitude & mask;
+
+    if (precision < 0) {
+        // r and the margin m, half a step of the format, count in units of
+        // 2^-(fp + 1) of the current digit. Stop once truncating (r < m) or
+        // rounding up (r > s - m) lands strictly within the margin.
+        constexpr wide_t s = wide_t(1) << (fp + 1);
+        wide_t r = wide_t(fraction) << 1;
+        wide_t m = 1;
+        while (r != 0) {
+            r *= 10;
+            m *= 10;
+            out.digits[out.count++] = static_cast<char>('0' + (r >> (fp + 1)));
+            r &= s - 1;
+
+            const bool low = r < m;
+            const bool high = r > s - m;
+            if (low && high) {
+                const bool odd = (out.digits[out.count - 1] - '0') & 1;
+                if ((r << 1) > s || ((r << 1) == s && odd))
+                    out.round_up();
+                break;
+            }
+            if (low)
+                break;
+            if (high) {
+                out.round_up();
+                break;
+            }
+        }
+    }
+    else {
+        const int n = std::min(precision, fp);
+        wide_t r = fraction;
+        for (int i = 0; i < n; i++) {
+            r *= 10;
+            out.digits[out.count++] = static_cast<char>('0' + (r >> fp));
+            r &= mask;
+        }
+        out.zeros = precision - n;
+
+        // Half to even on the exact remainder, over 2^fp.
+        const wide_t half = wide_t(1) << (fp - 1);
+        const bool odd = (n > 0) ? ((out.digits[n - 1] - '0') & 1) : (out.integer & 1);
+        if (r > half || (r == half && odd))
+            out.round_up();
+    }
+    return out;
+}
+
+}
+
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+std::to_chars_result to_chars(char* first, char* last, fixed<base, fp, ovf, rnd> value, int precision) {
+    const auto d = impl::to_decimal(value, precision);
+    if (std::size_t(last - first) < d.size())
+        return { last, std::errc::value_too_large };
+    return { d.write(first), std::errc() };
+}
+
+// Shortest round trip.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+std::to_chars_result to_chars(char* first, char* last, fixed<base, fp, ovf, rnd> value) {
+    return to_chars(first, last, value, -1);
+}
+
+// Writes values with separator between them. On running out of space,
+// returns value_too_large with ptr at the end of the last value that fit.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+std::to_chars_result to_chars(char* first, char* last, std::span<const fixed<base, fp, ovf, rnd>> values,
+                              char separator, int precision = -1) {
+    for (std::size_t i = 0; i < values.size(); i++) {
+        const auto d = impl::to_decimal(values[i], precision);
+        const std::size_t need = d.size() + (i > 0);
+        if (std::size_t(last - first) < need)
+            return { first, std::errc::value_too_large };
+
+        if (i > 0)
+            *first++ = separator;
+        first = d.write(first);
+    }
+    return { first, std::errc() };
+}
+
+struct from_chars_span_result {
+    const char* ptr;
+    std::errc ec;
+    std::size_t count;
+};
+
+namespace impl {
+
+inline constexpr std::array<u64, 20> pow10 = [] {
+    std::array<u64, 20> out{};
+    u64 v = 1;
+    for (auto& p : out) {
+        p = v;
+        v *= 10;
+    }
+    return out;
+}();
+
+// 2^(64 + shift) / 10^n rounded down, the largest such that fits 64 bits.
+struct reciprocal {
+    u64 m;
+    int shift;
+};
+
+inline constexpr std::array<reciprocal, 20> pow10_reciprocals = [] {
+    std::array<reciprocal, 20> out{};
+    for (std::size_t n = 1; n < out.size(); n++) {
+        const int shift = std::bit_width(pow10[n]) - 1;
+        out[n] = { static_cast<u64>((u128(1) << (64 + shift)) / pow10[n]), shift };
+    }
+    return out;
+}();
+
+constexpr bool is_digit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// The fraction 0.d1..dn, for n <= 19 digits held in d, rounded to fp bits.
+// The result is at most 2^fp, when it rounds up to one.
+template<int fp>
+constexpr u64 fraction_bits(u64 d, std::size_t n) {
+    if (n == 0)
+        return 0;
+    const u64 scale = pow10[n];
+    if (n <= 18 && (d >> (64 - fp)) == 0) {
+        // The reciprocal's quotient is at most one short.
+        const u64 num = d << fp;
+        const auto [m, shift] = pow10_reciprocals[n];
+        u64 q = static_cast<u64>((static_cast<u128>(num) * m) >> 64) >> shift;
+        u64 r = num - q * scale;
+        if (r >= scale) {
+            q++;
+            r -= scale;
+        }
+        return round_floor<rounding::half_even>(q, r, scale);
+    }
+    const u128 num = static_cast<u128>(d) << fp;
+    return static_cast<u64>(round_floor<rounding::half_even>(num / scale, num % scale, static_cast<u128>(scale)));
+}
+
+// The same for any number of digits in text. Ties between two fp-bit
+// values have exactly fp + 1 digits, so later digits only matter as
+// being nonzero. The first ones are doubled in decimal, carrying out one
+// bit at a time.
+template<int fp>
+constexpr u64 fraction_bits(const char* text, std::size_t n) {
+    std::array<u8, fp + 1> digits{};
+    const std::size_t m = std::min(n, std::size_t(fp + 1));
+    for (std::size_t i = 0; i < m; i++)
+        digits[i] = static_cast<u8>(text[i] - '0');
+    bool sticky = std::any_of(text + m, text + n, [](char c) { return c != '0'; });
+
+    u64 q = 0;
+    bool half = false;
+    for (int b = 0; b <= fp; b++) {
+        u8 carry = 0;
+        for (std::size_t i = m; i-- > 0;) {
+            const u8 v = static_cast<u8>(digits[i] * 2 + carry);
+            carry = v >= 10;
+            digits[i] = static_cast<u8>(v - carry * 10);
+        }
+        if (b < fp)
+            q = (q << 1) | carry;
+        else
+            half = carry;
+    }
+    sticky = sticky || std::any_of(digits.begin(), digits.begin() + m, [](u8 d) { return d != 0; });
+    return q + u64(half && (sticky || (q & 1)));
+}
+
+// Builds the value from its parts. integer saturates at u64 max, and the
+// fraction is held in fraction for up to 19 digits, or else read from text.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+constexpr std::errc compose(bool negative, u64 integer, u64 fraction, const char* text, std::size_t digits,
+                            fixed<base, fp, ovf, rnd>& value) {
+    using ut = std::make_unsigned_t<base>;
+    constexpr u64 max_magnitude = static_cast<u64>(std::numeric_limits<base>::max());
+    const u64 limit = max_magnitude + u64(negative);
+    if (integer > (limit >> fp))
+        return std::errc::result_out_of_range;
+
+    const u64 whole = integer << fp;
+    const u64 q = (digits <= 19) ? fraction_bits<fp>(fraction, digits) : fraction_bits<fp>(text, digits);
+    if (q > limit - whole)
+        return std::errc::result_out_of_range;
+
+    const ut magnitude = static_cast<ut>(whole + q);
+    value = fixed<base, fp, ovf, rnd>::from_raw(static_cast<base>(negative ? ut(ut(0) - magnitude) : magnitude));
+    return std::errc();
+}
+
+// [-]digits[.[digits]] or [-].digits, with a minus only for signed bases.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+constexpr std::from_chars_result parse_decimal(const char* first, const char* last, fixed<base, fp, ovf, rnd>& value) {
+    constexpr u64 saturate = (~u64(0) - 9) / 10;
+    const char* p = first;
+
+    bool negative = false;
+    if constexpr(std::is_signed_v<base>) {
+        negative = p != last && *p == '-';
+        p += negative;
+    }
+
+    u64 integer = 0;
+    const char* const integer_text = p;
+    for (; p != last && is_digit(*p); p++)
+        integer = (integer > saturate) ? ~u64(0) : integer * 10 + u64(*p - '0');
+    bool any = p != integer_text;
+
+    u64 fraction = 0;
+    const char* fraction_text = p;
+    std::size_t digits = 0;
+    if (p != last && *p == '.') {
+        const char* q = p + 1;
+        for (; q != last && is_digit(*q); q++) {
+            if (q - (p + 1) < 19)
+                fraction = fraction * 10 + u64(*q - '0');
+        }
+        if (any || q != p + 1) {
+            fraction_text = p + 1;
+            digits = std::size_t(q - fraction_text);
+            p = q;
+            any = true;
+        }
+    }
+
+    if (!any)
+        return { first, std::errc::invalid_argument };
+    return { p, compose(negative, integer, fraction, fraction_text, digits, value) };
+}
+
+constexpr bool is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+constexpr bool is_space(char c) {
+    return is_blank(c) || c == '\n' || c == '\r';
+}
+
+// After a value: blanks, then the separator, a line break or the end.
+// Returns the start of the next field, or nullptr on anything else.
+constexpr const char* next_field(const char* p, const char* last, char separator) {
+    while (p != last && is_blank(*p))
+        p++;
+    if (p == last || *p == '\n' || *p == '\r')
+        return p;
+    return (*p == separator) ? p + 1 : nullptr;
+}
+
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+constexpr from_chars_span_result parse_fields(const char* first, const char* last, std::span<fixed<base, fp, ovf, rnd>> out,
+                            char separator, std::size_t i) {
+    const char* p = first;
+    for (; i < out.size(); i++) {
+        while (p != last && is_space(*p))
+            p++;
+        if (p == last)
+            break;
+
+        const auto r = parse_decimal(p, last, out[i]);
+        if (r.ec != std::errc())
+            return from_chars_span_result{ p, r.ec, i };
+        const char* next = next_field(r.ptr, last, separator);
+        if (!next)
+            return from_chars_span_result{ p, std::errc::invalid_argument, i };
+        p = next;
+    }
+    return from_chars_span_result{ p, std::errc(), i };
+}
+
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+// The n <= 16 digits at p as an integer. Reads 16 bytes.
+FXD_TARGET_AVX2 inline u64 digits16(const char* p, std::size_t n) {
+    // Loaded at offset n, this right-aligns the n digits and zeroes the rest.
+    alignas(32) static constexpr i8 align[32] = {
+        -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128,
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+    };
+
+    __m128i v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+    v = _mm_shuffle_epi8(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(align + n)));
+    v = _mm_maddubs_epi16(v, _mm_set1_epi16(0x010a));   // Pairs
+    v = _mm_madd_epi16(v, _mm_set1_epi32(0x00010064));  // Fours
+    v = _mm_packus_epi32(v, v);
+    v = _mm_madd_epi16(v, _mm_set1_epi32(0x00012710));  // Eights
+    return u64(u32(_mm_cvtsi128_si32(v))) * 100000000 + u32(_mm_extract_epi32(v, 1));
+}
+
+// One number with at most 16 digits on each side of the point, ending
+// within the 32 bytes after the sign. Reads up to 64 bytes from first,
+// and returns a null ptr for anything else.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+FXD_TARGET_AVX2 inline std::from_chars_result parse_decimal(const char* first, fixed<base, fp, ovf, rnd>& value) {
+    const char* p = first;
+    bool negative = false;
+    if constexpr(std::is_signed_v<base>) {
+        negative = *p == '-';
+        p += negative;
+    }
+
+    const __m256i text = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i x = _mm256_sub_epi8(text, _mm256_set1_epi8('0'));
+    const u32 digit = u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(9)), x)));
+    const u32 dot = u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(text, _mm256_set1_epi8('.'))));
+
+    const int integer_length = std::countr_zero(~digit);
+    if (integer_length > 16)
+        return { nullptr, std::errc() };
+
+    int fraction_start = integer_length;
+    int fraction_length = 0;
+    if ((dot >> integer_length) & 1) {
+        fraction_start = integer_length + 1;
+        fraction_length = std::countr_zero(~(digit >> fraction_start));
+    }
+    const int end = fraction_start + fraction_length;
+    if (fraction_length > 16 || end >= 32 || integer_length + fraction_length == 0)
+        return { nullptr, std::errc() };
+
+    const u64 integer = digits16(p, std::size_t(integer_length));
+    const u64 fraction = digits16(p + fraction_start, std::size_t(fraction_length));
+    return { p + end, compose(negative, integer, fraction, p + fraction_start, std::size_t(fraction_length), value) };
+}
+
+// Parses fields while 96 bytes remain, stopping before anything unusual
+// for the scalar loop to handle. Each 32-byte block is searched for field
+// ends first, so a field's start never waits on parsing the one before.
+// Returns the count, and advances p past those fields.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+FXD_TARGET_AVX2 std::size_t parse_fields(const char*& p, const char* last, fixed<base, fp, ovf, rnd>* out,
+                                         std::size_t n, char separator) {
+    std::size_t i = 0;
+    while (i < n && last - p >= 96) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i ends = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(separator)),
+                                             _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+        u32 mask = u32(_mm256_movemask_epi8(ends));
+        if (mask == 0)
+            return i;
+
+        const char* const base_p = p;
+        for (; mask != 0 && i < n; mask &= mask - 1) {
+            const char* const end = base_p + std::countr_zero(mask);
+            const char* a = p;
+            const char* b = end;
+            while (a != b && is_space(*a))
+                a++;
+            while (b != a && is_space(b[-1]))
+                b--;
+
+            // Only line breaks may end an empty field.
+            if (a == b) {
+                if (*end != '\n')
+                    return i;
+                p = end + 1;
+                continue;
+            }
+
+            auto r = parse_decimal(a, out[i]);
+            if (!r.ptr)
+                r = impl::parse_decimal(a, b, out[i]);
+            if (r.ec != std::errc() || r.ptr != b)
+                return i;
+            i++;
+            p = end + 1;
+        }
+    }
+    return i;
+}
+
+}
+#endif
+
+}
+
+// Reads one value in fixed notation, or with std::chars_format::hex the raw
+// bits as a hexadecimal integer, as std::from_chars reads one.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+std::from_chars_result from_chars(const char* first, const char* last, fixed<base, fp, ovf, rnd>& value,
+                                  std::chars_format format = std::chars_format::fixed) {
+    if (format == std::chars_format::hex) {
+        base raw;
+        const auto r = std::from_chars(first, last, raw, 16);
+        if (r.ec == std::errc())
+            value = fixed<base, fp, ovf, rnd>::from_raw(raw);
+        return r;
+    }
+    return impl::parse_decimal(first, last, value);
+}
+
+// Reads values separated by separator or line breaks into out, skipping
+// blanks around them and blank lines. Stops when out is full, at the end of
+// the text, or at the first field that is not a value. ptr is then the
+// start of that field, and count the number of values read.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+from_chars_span_result from_chars(const char* first, const char* last, std::span<fixed<base, fp, ovf, rnd>> out,
+                                  char separator = ',') {
+    std::size_t done = 0;
+#ifdef FXD_X86_SIMD
+    if (impl::has_avx2())
+        done = impl::avx2::parse_fields(first, last, out.data(), out.size(), separator);
+#endif
+    return impl::parse_fields(first, last, out, separator, done);
+}
+
+namespace impl {
+
+// [[fill]align][sign][width][.precision], the std-format spec minus the
+// type, # and 0 options. Kept outside std::formatter so it has no need for
+// <format> itself.
+struct format_spec {
+    char fill = ' ';
+    char align = '>';
+    char sign = '-';
+    int width = 0;
+    int precision = -1;
+
+    // Returns the position of the closing brace, or nullptr when the spec
+    // is malformed.
+    template<typename It>
+    constexpr It parse(It it, It end) {
+        auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+        auto number = [&](int& out) {
+            out = 0;
+            for (; it != end && *it >= '0' && *it <= '9'; ++it)
+                out = out * 10 + (*it - '0');
+        };
+
+        if (it != end && *it != '}' && std::next(it) != end && is_align(*std::next(it))) {
+            fill = *it;
+            align = *std::next(it);
+            it += 2;
+        }
+        else if (it != end && is_align(*it)) {
+            align = *it++;
+        }
+
+        if (it != end && (*it == '+' || *it == '-' || *it == ' '))
+            sign = *it++;
+
+        number(width);
+        if (it != end && *it == '.') {
+            ++it;
+            if (it == end || *it < '0' || *it > '9')
+                return It{};
+            number(precision);
+        }
+
+        if (it != end && *it != '}')
+            return It{};
+        return it;
+    }
+
+    template<typename Out, std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+    Out format(Out out, fixed<base, fp, ovf, rnd> value) const {
+        const auto d = to_decimal(value, precision);
+        const bool extra_sign = !d.negative && sign != '-';
+        const std::size_t size = d.size() + extra_sign;
+        const std::size_t pad = (std::size_t(width) > size) ? std::size_t(width) - size : 0;
+        const std::size_t before = (align == '>') ? pad : (align == '^') ? pad / 2 : 0;
+
+        out = std::fill_n(out, before, fill);
+        if (extra_sign)
+            *out++ = sign;
+        out = d.write(out);
+        return std::fill_n(out, pad - before, fill);
+    }
+};
+
+}
+
+}
+
+#ifdef __cpp_lib_format
+template<std::integral base, int fp, fxd::overflow_policy ovf, fxd::rounding_policy rnd>
+struct std::formatter<fxd::fixed<base, fp, ovf, rnd>, char> {
+    fxd::impl::format_spec spec;
+
+    constexpr auto parse(std::format_parse_context& ctx) {
+        const auto it = spec.parse(ctx.begin(), ctx.end());
+        if (it == decltype(it){})
+            throw std::format_error("fxd: invalid format spec for fixed");
+        return it;
+    }
+
+    template<typename FormatContext>
+    auto format(fxd::fixed<base, fp, ovf, rnd> value, FormatContext& ctx) const {
+        return spec.format(ctx.out(), value);
+    }
+};
+#endif
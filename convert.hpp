@@ -0,0 +1,247 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+#include "./fixed.hpp"
+#include "./simd.hpp"
+
+// Span versions of the conversions in fixed.hpp: from float and double,
+// back to them, and between two fixed formats. Overflow and rounding follow
+// the policies of the destination type, so saturation and round to nearest
+// are picked the same way as for a single value, e.g.
+//
+//   using sample_t = fxd::fixed<fxd::i32, 16, fxd::overflow::saturate, fxd::rounding::half_even>;
+//   fxd::convert(std::span<const float>(frame), std::span<sample_t>(samples));
+//
+// Outputs must be at least as long as the input, and results are
+// bit-identical to converting each element. The AVX2 kernels cover i32
+// formats under every policy but stochastic rounding, which draws from its
+// source once per element, in order.
+
+namespace fxd {
+
+namespace impl {
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+// impl::round_float on eight floats. floor gives the same f as the scalar
+// i64 round trip, so half_up takes the same steps. half_even matches a
+// plain round to nearest even, which the scalar steps also compute.
+template<rounding_policy rnd>
+FXD_TARGET_AVX2 inline __m256 round_float(__m256 v) {
+    if constexpr(std::is_same_v<rnd, rounding::half_even>) {
+        return _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+    else if constexpr(std::is_same_v<rnd, rounding::half_up>) {
+        const __m256 f = _mm256_floor_ps(v);
+        const __m256 up = _mm256_cmp_ps(_mm256_sub_ps(v, f), _mm256_set1_ps(0.5f), _CMP_GE_OQ);
+        return _mm256_add_ps(f, _mm256_and_ps(up, _mm256_set1_ps(1.0f)));
+    }
+    else {
+        return v;
+    }
+}
+
+template<rounding_policy rnd>
+FXD_TARGET_AVX2 inline __m256d round_float(__m256d v) {
+    if constexpr(std::is_same_v<rnd, rounding::half_even>) {
+        return _mm256_round_pd(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+    else if constexpr(std::is_same_v<rnd, rounding::half_up>) {
+        const __m256d f = _mm256_floor_pd(v);
+        const __m256d up = _mm256_cmp_pd(_mm256_sub_pd(v, f), _mm256_set1_pd(0.5), _CMP_GE_OQ);
+        return _mm256_add_pd(f, _mm256_and_pd(up, _mm256_set1_pd(1.0)));
+    }
+    else {
+        return v;
+    }
+}
+
+// impl::from_float into i32 lanes. The truncating conversion already turns
+// NaN and out of range lanes into INT32_MIN, as the scalar cast does on x86,
+// so saturation only patches NaN and the upper side.
+template<overflow_policy ovf>
+FXD_TARGET_AVX2 inline __m256i from_float(__m256i raw, __m256i over, __m256i under, __m256i nan) {
+    if constexpr(checks_overflow<ovf>) {
+        if constexpr(std::is_same_v<ovf, overflow::saturate>) {
+            return select(_mm256_andnot_si256(nan, raw), set1(std::numeric_limits<i32>::max()), over);
+        }
+        else {
+            const __m256i bad = _mm256_or_si256(_mm256_or_si256(over, under), nan);
+            if (!_mm256_testz_si256(bad, bad))
+                __builtin_trap();
+        }
+    }
+    return raw;
+}
+
+template<int fp, overflow_policy ovf, rounding_policy rnd>
+FXD_TARGET_AVX2 inline __m256i from_float(__m256 v) {
+    v = round_float<rnd>(_mm256_mul_ps(v, _mm256_set1_ps(float(i64(1) << fp))));
+
+    const __m256 over = _mm256_cmp_ps(v, _mm256_set1_ps(0x1p31f), _CMP_GE_OQ);
+    const __m256 under = _mm256_cmp_ps(v, _mm256_set1_ps(-0x1p31f), _CMP_LT_OQ);
+    const __m256 nan = _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+    return from_float<ovf>(_mm256_cvttps_epi32(v), _mm256_castps_si256(over),
+                           _mm256_castps_si256(under), _mm256_castps_si256(nan));
+}
+
+// Packs the 64-bit compare masks of a and b into eight 32-bit lanes, in order.
+FXD_TARGET_AVX2 inline __m256i pack_masks(__m256d a, __m256d b) {
+    const __m256i low_words = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const __m256i lo = _mm256_permutevar8x32_epi32(_mm256_castpd_si256(a), low_words);
+    const __m256i hi = _mm256_permutevar8x32_epi32(_mm256_castpd_si256(b), low_words);
+    return _mm256_blend_epi32(lo, hi, 0xf0);
+}
+
+// Eight doubles from two registers, in order.
+template<int fp, overflow_policy ovf, rounding_policy rnd>
+FXD_TARGET_AVX2 inline __m256i from_float(__m256d lo, __m256d hi) {
+    const __m256d scale = _mm256_set1_pd(double(i64(1) << fp));
+    lo = round_float<rnd>(_mm256_mul_pd(lo, scale));
+    hi = round_float<rnd>(_mm256_mul_pd(hi, scale));
+
+    const __m256i raw = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(lo)),
+                                                 _mm256_cvttpd_epi32(hi), 1);
+    const __m256d top = _mm256_set1_pd(0x1p31);
+    const __m256d bottom = _mm256_set1_pd(-0x1p31);
+    return from_float<ovf>(raw,
+        pack_masks(_mm256_cmp_pd(lo, top, _CMP_GE_OQ), _mm256_cmp_pd(hi, top, _CMP_GE_OQ)),
+        pack_masks(_mm256_cmp_pd(lo, bottom, _CMP_LT_OQ), _mm256_cmp_pd(hi, bottom, _CMP_LT_OQ)),
+        pack_masks(_mm256_cmp_pd(lo, lo, _CMP_UNORD_Q), _mm256_cmp_pd(hi, hi, _CMP_UNORD_Q)));
+}
+
+// The fixed-to-fixed conversion operator between i32 formats.
+template<int from, int to, overflow_policy ovf, rounding_policy rnd>
+FXD_TARGET_AVX2 inline __m256i rescale(__m256i v) {
+    if constexpr(to > from) {
+        constexpr int s = to - from;
+        const __m256i out = _mm256_slli_epi32(v, s);
+        if constexpr(checks_overflow<ovf>) {
+            const __m256i bad = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_srai_epi32(out, s), v), set1(-1));
+            if constexpr(std::is_same_v<ovf, overflow::saturate>) {
+                const __m256i limit = _mm256_xor_si256(_mm256_srai_epi32(v, 31), set1(std::numeric_limits<i32>::max()));
+                return select(out, limit, bad);
+            }
+            else {
+                if (!_mm256_testz_si256(bad, bad))
+                    __builtin_trap();
+            }
+        }
+        return out;
+    }
+    else if constexpr(to < from) {
+        // Narrowing only shrinks the value, so no policy can overflow here.
+        constexpr int s = from - to;
+        const __m256i q = _mm256_srai_epi32(v, s);
+        if constexpr(std::is_same_v<rnd, rounding::half_up>) {
+            return _mm256_add_epi32(q, _mm256_and_si256(_mm256_srli_epi32(v, s - 1), set1(1)));
+        }
+        else if constexpr(std::is_same_v<rnd, rounding::half_even>) {
+            const __m256i r = _mm256_and_si256(v, set1((1 << s) - 1));
+            const __m256i odd = _mm256_and_si256(q, set1(1));
+            return _mm256_sub_epi32(q, _mm256_cmpgt_epi32(_mm256_add_epi32(r, odd), set1(1 << (s - 1))));
+        }
+        else {
+            // Division rounds towards zero: bias negative lanes by 2^s - 1.
+            const __m256i bias = _mm256_srli_epi32(_mm256_srai_epi32(v, 31), 32 - s);
+            return _mm256_srai_epi32(_mm256_add_epi32(v, bias), s);
+        }
+    }
+    else {
+        return v;
+    }
+}
+
+template<int fp, overflow_policy ovf, rounding_policy rnd, typename T>
+FXD_TARGET_AVX2 std::size_t from_float(const float* in, T* out, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        store(out + i, from_float<fp, ovf, rnd>(_mm256_loadu_ps(in + i)));
+    return i;
+}
+
+template<int fp, overflow_policy ovf, rounding_policy rnd, typename T>
+FXD_TARGET_AVX2 std::size_t from_float(const double* in, T* out, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        store(out + i, from_float<fp, ovf, rnd>(_mm256_loadu_pd(in + i), _mm256_loadu_pd(in + i + 4)));
+    return i;
+}
+
+// raw / 2^fp is exact, so multiplying by 2^-fp gives the scalar quotient.
+template<int fp, typename T>
+FXD_TARGET_AVX2 std::size_t to_float(const T* in, float* out, std::size_t n) {
+    const __m256 scale = _mm256_set1_ps(1.0f / float(i64(1) << fp));
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(load(in + i)), scale));
+    return i;
+}
+
+template<int fp, typename T>
+FXD_TARGET_AVX2 std::size_t to_float(const T* in, double* out, std::size_t n) {
+    const __m256d scale = _mm256_set1_pd(1.0 / double(i64(1) << fp));
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i v = load(in + i);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), scale));
+        _mm256_storeu_pd(out + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), scale));
+    }
+    return i;
+}
+
+}
+#endif
+
+// Float types with a kernel.
+template<typename F>
+constexpr bool simd_float = std::is_same_v<F, float> || std::is_same_v<F, double>;
+
+}
+
+template<std::floating_point F, std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+void convert(std::span<const F> in, std::span<fixed<base, fp, ovf, rnd>> out) {
+    using fixed_t = fixed<base, fp, ovf, rnd>;
+
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32> && impl::simd_float<F> && !impl::is_stochastic<rnd>)
+        if (impl::has_avx2())
+            i = impl::avx2::from_float<fp, ovf, rnd>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = fixed_t(in[i]);
+}
+
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd, std::floating_point F>
+void convert(std::span<const fixed<base, fp, ovf, rnd>> in, std::span<F> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32> && impl::simd_float<F>)
+        if (impl::has_avx2())
+            i = impl::avx2::to_float<fp>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = static_cast<F>(in[i]);
+}
+
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd,
+         std::integral other_base, int other_fp, overflow_policy other_ovf, rounding_policy other_rnd>
+void convert(std::span<const fixed<base, fp, ovf, rnd>> in, std::span<fixed<other_base, other_fp, other_ovf, other_rnd>> out) {
+    using other_t = fixed<other_base, other_fp, other_ovf, other_rnd>;
+
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32> && std::is_same_v<other_base, i32> && !impl::is_stochastic<other_rnd>)
+        if (impl::has_avx2())
+            i = impl::avx2::map<impl::avx2::rescale<fp, other_fp, other_ovf, other_rnd>>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = static_cast<other_t>(in[i]);
+}
+
+}
@@ -0,0 +1,421 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <span>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./math_helper.hpp"
+#include "./batch.hpp"
+
+// CORDIC.
+//
+// fxd::cordic:: computes sincos, atan2, hypot and polar form with shifts
+// and adds only, one bit per step. Rotation mode turns (1 / K, 0) through an
+// angle, and leaves its cos and sin. Vectoring mode turns (x, y) onto the x
+// axis, and leaves K * r in x and the angle it turned through. So atan2 and
+// hypot come out of the same pass, and hypot never squares its inputs.
+//
+// x, y and the angle are 32-bit values with 30 fraction bits. A format takes
+// frac_bits + 2 steps, up to 30, with an arctan table of that length built
+// at compile time, so angles and sincos are good to about an ulp of the
+// input. hypot is good to about 2^-26 of r, relative. Vectoring mode takes
+// bases up to 32 bits. The span versions run eight vectors per AVX2 register
+// and are bit-identical to the scalar functions.
+
+namespace fxd {
+
+namespace impl {
+
+constexpr int cordic_fp = 30;
+
+template<int fp>
+constexpr int cordic_steps = std::min(fp + 2, cordic_fp);
+
+// The magnitude is short by 1 - cos of the angle left over, so vectoring
+// takes at least 16 steps to keep it to the 28 bits it is worked in.
+template<int fp>
+constexpr int cordic_vector_steps = std::max(cordic_steps<fp>, 16);
+
+// atan(x) for x: [0, 0.5], at compile time.
+consteval double taylor_atan(double x) {
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 28; i++) {
+        term *= -x * x;
+        sum += term / (2 * i + 1);
+    }
+    return sum;
+}
+
+// atan(2^-i) in Q30, starting from pi / 4.
+template<int steps>
+consteval std::array<i32, steps> make_cordic_atan() {
+    std::array<i32, steps> out{};
+    out[0] = q126_bits<i32>(half_pi_q126, cordic_fp - 1);
+    for (int i = 1; i < steps; i++)
+        out[i] = static_cast<i32>(taylor_atan(1.0 / double(u64(1) << i)) * (1 << cordic_fp) + 0.5);
+    return out;
+}
+
+// 1 / K in Q32, where K = prod sqrt(1 + 4^-i) is the gain of the steps.
+template<int steps>
+consteval u32 make_cordic_scale() {
+    double k2 = 1;
+    for (int i = 0; i < steps; i++)
+        k2 *= 1 + 1.0 / double(u64(1) << (2 * i));
+
+    double y = 0.6;
+    for (int i = 0; i < 8; i++)
+        y *= 1.5 - 0.5 * k2 * y * y;
+    return static_cast<u32>(y * 4294967296.0 + 0.5);
+}
+
+template<int steps>
+constexpr inline std::array<i32, steps> cordic_atan = make_cordic_atan<steps>();
+
+template<int steps>
+constexpr inline u32 cordic_scale = make_cordic_scale<steps>();
+
+// Rotation mode: turns (x, y) through z, for |z| under 1.74.
+template<int steps>
+constexpr void cordic_rotate(i32& x, i32& y, i32 z) {
+    for (int i = 0; i < steps; i++) {
+        const i32 dx = y >> i;
+        const i32 dy = x >> i;
+        if (z < 0) {
+            x += dx;
+            y -= dy;
+            z += cordic_atan<steps>[i];
+        }
+        else {
+            x -= dx;
+            y += dy;
+            z -= cordic_atan<steps>[i];
+        }
+    }
+}
+
+// Vectoring mode: turns (x, y), x >= 0, onto the x axis. x is left as K * r,
+// and the angle turned through is returned.
+template<int steps>
+constexpr i32 cordic_vector(i32& x, i32 y) {
+    i32 z = 0;
+    for (int i = 0; i < steps; i++) {
+        const i32 dx = y >> i;
+        const i32 dy = x >> i;
+        if (y < 0) {
+            x -= dx;
+            y += dy;
+            z -= cordic_atan<steps>[i];
+        }
+        else {
+            x += dx;
+            y -= dy;
+            z += cordic_atan<steps>[i];
+        }
+    }
+    return z;
+}
+
+// Q30 to trig_t, rounded to nearest.
+constexpr trig_t cordic_result(i32 v) {
+    return trig_t::from_raw((v + 4) >> 3);
+}
+
+// The magnitude of (x, y) in the raw units of the format, and atan2(y, x).
+// Vectoring runs on |x| and |y|, scaled so the larger has its top bit at
+// bit 28 and K * r stays under 2, and the signs place the angle afterwards.
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i32))
+constexpr void cordic_polar(fixed<base, fp> x, fixed<base, fp> y, u64& out_r, trig_t& out_theta) {
+    constexpr int steps = cordic_vector_steps<fp>;
+    const i64 sx = x.raw();
+    const i64 sy = y.raw();
+    const u32 ax = static_cast<u32>((sx < 0) ? -sx : sx);
+    const u32 ay = static_cast<u32>((sy < 0) ? -sy : sy);
+    const u32 m = std::max(ax, ay);
+
+    if (m == 0) {
+        out_r = 0;
+        out_theta = 0;
+        return;
+    }
+
+    const int k = (cordic_fp - 2) - ilog2(m);
+    auto normalize = [k] (u32 v) { return static_cast<i32>((k >= 0) ? (v << k) : (v >> -k)); };
+
+    i32 vx = normalize(ax);
+    const i32 z = cordic_vector<steps>(vx, normalize(ay));
+
+    // K * r * 2^k / K, rounded to nearest.
+    out_r = (((u64(u32(vx)) * cordic_scale<steps>) >> (31 + k)) + 1) >> 1;
+
+    const trig_t theta = (sx < 0) ? pi<trig_t> - cordic_result(z) : cordic_result(z);
+    out_theta = (sy < 0) ? -theta : theta;
+}
+
+}
+
+namespace cordic {
+
+// Rotation
+
+template<std::integral base, int fp>
+constexpr void sincos(fixed<base, fp> s, trig_t& out_sin, trig_t& out_cos) {
+    static_assert(fixed<base, fp>::is_signed, "sincos only supports signed fixed types!");
+    constexpr int steps = impl::cordic_steps<fp>;
+
+    int quadrant;
+    const trig_t x = impl::reduce_half_pi(s, quadrant);
+
+    i32 c = static_cast<i32>((impl::cordic_scale<steps> + 2) >> 2);
+    i32 sn = 0;
+    impl::cordic_rotate<steps>(c, sn, x.raw() << (impl::cordic_fp - trig_t::frac_bits));
+
+    // Odd quadrant = flip inputs
+    out_cos = impl::cordic_result((quadrant & 1) ? sn : c);
+    out_sin = impl::cordic_result((quadrant & 1) ? c : sn);
+
+    out_cos = (quadrant == 1 || quadrant == 2) ? -out_cos : out_cos;
+    out_sin = ((quadrant & 2) != 0) != (s < 0) ? -out_sin : out_sin;
+}
+
+template<std::integral base, int fp>
+constexpr trig_t sin(fixed<base, fp> s) {
+    trig_t out_sin, out_cos;
+    cordic::sincos(s, out_sin, out_cos);
+    return out_sin;
+}
+
+template<std::integral base, int fp>
+constexpr trig_t cos(fixed<base, fp> s) {
+    trig_t out_sin, out_cos;
+    cordic::sincos(s, out_sin, out_cos);
+    return out_cos;
+}
+
+// Vectoring
+
+// The magnitude, narrowed with the format's overflow policy, and the angle
+// of (x, y) from one pass.
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i32))
+constexpr void polar(fixed<base, fp> x, fixed<base, fp> y, fixed<base, fp>& out_r, trig_t& out_theta) {
+    using fixed_t = fixed<base, fp>;
+    u64 r;
+    impl::cordic_polar(x, y, r, out_theta);
+    out_r = fixed_t::from_raw(impl::narrow<typename fixed_t::overflow_type, base>(r));
+}
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i32))
+constexpr trig_t atan2(fixed<base, fp> y, fixed<base, fp> x) {
+    u64 r;
+    trig_t theta;
+    impl::cordic_polar(x, y, r, theta);
+    return theta;
+}
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i32))
+constexpr fixed<base, fp> hypot(fixed<base, fp> x, fixed<base, fp> y) {
+    fixed<base, fp> r;
+    trig_t theta;
+    cordic::polar(x, y, r, theta);
+    return r;
+}
+
+}
+
+namespace impl {
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+template<int steps>
+FXD_TARGET_AVX2 inline void cordic_rotate(__m256i& x, __m256i& y, __m256i z) {
+    for (int i = 0; i < steps; i++) {
+        const __m128i n = _mm_cvtsi32_si128(i);
+        const __m256i negative = _mm256_srai_epi32(z, 31);
+        const __m256i dx = negate_if(_mm256_sra_epi32(y, n), negative);
+        const __m256i dy = negate_if(_mm256_sra_epi32(x, n), negative);
+        x = _mm256_sub_epi32(x, dx);
+        y = _mm256_add_epi32(y, dy);
+        z = _mm256_sub_epi32(z, negate_if(set1(cordic_atan<steps>[i]), negative));
+    }
+}
+
+template<int steps>
+FXD_TARGET_AVX2 inline __m256i cordic_vector(__m256i& x, __m256i y) {
+    __m256i z = _mm256_setzero_si256();
+    for (int i = 0; i < steps; i++) {
+        const __m128i n = _mm_cvtsi32_si128(i);
+        const __m256i negative = _mm256_srai_epi32(y, 31);
+        const __m256i dx = negate_if(_mm256_sra_epi32(y, n), negative);
+        const __m256i dy = negate_if(_mm256_sra_epi32(x, n), negative);
+        x = _mm256_add_epi32(x, dx);
+        y = _mm256_sub_epi32(y, dy);
+        z = _mm256_add_epi32(z, negate_if(set1(cordic_atan<steps>[i]), negative));
+    }
+    return z;
+}
+
+FXD_TARGET_AVX2 inline __m256i cordic_result(__m256i v) {
+    return _mm256_srai_epi32(_mm256_add_epi32(v, set1(4)), 3);
+}
+
+template<int fp>
+FXD_TARGET_AVX2 inline void cordic_sincos(__m256i s, __m256i& out_sin, __m256i& out_cos) {
+    constexpr int steps = cordic_steps<fp>;
+    __m256i quadrant;
+    const __m256i x = reduce_quadrant<fp>(s, quadrant);
+
+    __m256i c = set1(static_cast<i32>((cordic_scale<steps> + 2) >> 2));
+    __m256i sn = _mm256_setzero_si256();
+    cordic_rotate<steps>(c, sn, _mm256_slli_epi32(x, cordic_fp - trig_t::frac_bits));
+    unfold_quadrant(s, quadrant, cordic_result(sn), cordic_result(c), out_sin, out_cos);
+}
+
+// cordic_polar on eight lanes. The raw magnitude is returned in its low 32
+// bits, which is the wrap-around narrowing of the span's format.
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i cordic_polar(__m256i x, __m256i y, __m256i& out_theta) {
+    constexpr int steps = cordic_vector_steps<fp>;
+    const __m256i ax = _mm256_abs_epi32(x);
+    const __m256i ay = _mm256_abs_epi32(y);
+    const __m256i m = _mm256_max_epu32(ax, ay);
+    const __m256i zero = _mm256_cmpeq_epi32(m, _mm256_setzero_si256());
+
+    // ilog2 takes positive lanes, and only |min| = 2^31 is not.
+    const __m256i top = _mm256_cmpeq_epi32(m, set1(INT32_MIN));
+    const __m256i log2 = _mm256_sub_epi32(ilog2(_mm256_min_epu32(m, set1(INT32_MAX))), top);
+    const __m256i k = _mm256_sub_epi32(set1(cordic_fp - 2), log2);
+    const __m256i neg_k = _mm256_sub_epi32(_mm256_setzero_si256(), k);
+
+    __m256i vx = shift_right(ax, neg_k);
+    const __m256i z = cordic_vector<steps>(vx, shift_right(ay, neg_k));
+
+    // The rounded product on 64-bit lanes, with a shift of 31 + k each.
+    const __m256i scale = _mm256_set1_epi64x(cordic_scale<steps>);
+    const __m256i count = _mm256_add_epi32(k, set1(31));
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i r_even = _mm256_srlv_epi64(_mm256_mul_epu32(vx, scale), _mm256_and_si256(count, _mm256_set1_epi64x(0xffffffff)));
+    const __m256i r_odd = _mm256_srlv_epi64(_mm256_mul_epu32(_mm256_srli_epi64(vx, 32), scale), _mm256_srli_epi64(count, 32));
+    const __m256i r = _mm256_blend_epi32(_mm256_srli_epi64(_mm256_add_epi64(r_even, one), 1),
+                                         _mm256_slli_epi64(_mm256_srli_epi64(_mm256_add_epi64(r_odd, one), 1), 32), 0xaa);
+
+    __m256i theta = cordic_result(z);
+    theta = select(theta, _mm256_sub_epi32(set1(pi<trig_t>.raw()), theta), _mm256_cmpgt_epi32(_mm256_setzero_si256(), x));
+    theta = negate_if(theta, _mm256_cmpgt_epi32(_mm256_setzero_si256(), y));
+    out_theta = _mm256_andnot_si256(zero, theta);
+    return _mm256_andnot_si256(zero, r);
+}
+
+template<int fp, bool want_sin, bool want_cos>
+FXD_TARGET_AVX2 std::size_t cordic_sincos(const fixed<i32, fp>* in, trig_t* out_sin, trig_t* out_cos, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i s, c;
+        cordic_sincos<fp>(load(in + i), s, c);
+        if constexpr(want_sin) store(out_sin + i, s);
+        if constexpr(want_cos) store(out_cos + i, c);
+    }
+    return i;
+}
+
+template<int fp, bool want_r, bool want_theta>
+FXD_TARGET_AVX2 std::size_t cordic_polar(const fixed<i32, fp>* x, const fixed<i32, fp>* y,
+                                         fixed<i32, fp>* out_r, trig_t* out_theta, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i theta;
+        const __m256i r = cordic_polar<fp>(load(x + i), load(y + i), theta);
+        if constexpr(want_r) store(out_r + i, r);
+        if constexpr(want_theta) store(out_theta + i, theta);
+    }
+    return i;
+}
+
+}
+#endif
+
+template<bool want_sin, bool want_cos, std::integral base, int fp>
+std::size_t cordic_sincos_kernel(std::span<const fixed<base, fp>> in, trig_t* out_sin, trig_t* out_cos) {
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>) {
+        if (has_avx2())
+            return avx2::cordic_sincos<fp, want_sin, want_cos>(in.data(), out_sin, out_cos, in.size());
+    }
+#endif
+    return 0;
+}
+
+template<bool want_r, bool want_theta, std::integral base, int fp>
+std::size_t cordic_polar_kernel(std::span<const fixed<base, fp>> x, std::span<const fixed<base, fp>> y,
+                                fixed<base, fp>* out_r, trig_t* out_theta) {
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>) {
+        if (has_avx2())
+            return avx2::cordic_polar<fp, want_r, want_theta>(x.data(), y.data(), out_r, out_theta, x.size());
+    }
+#endif
+    return 0;
+}
+
+}
+
+namespace cordic {
+
+// Outputs must be at least as long as the inputs.
+
+template<std::integral base, int fp>
+void sincos(std::span<const fixed<base, fp>> in, std::span<trig_t> out_sin, std::span<trig_t> out_cos) {
+    static_assert(fixed<base, fp>::is_signed, "sincos only supports signed fixed types!");
+
+    std::size_t i = impl::cordic_sincos_kernel<true, true>(in, out_sin.data(), out_cos.data());
+    for (; i < in.size(); i++)
+        cordic::sincos(in[i], out_sin[i], out_cos[i]);
+}
+
+template<std::integral base, int fp>
+void sin(std::span<const fixed<base, fp>> in, std::span<trig_t> out) {
+    static_assert(fixed<base, fp>::is_signed, "sin only supports signed fixed types!");
+
+    std::size_t i = impl::cordic_sincos_kernel<true, false>(in, out.data(), nullptr);
+    for (; i < in.size(); i++)
+        out[i] = cordic::sin(in[i]);
+}
+
+template<std::integral base, int fp>
+void cos(std::span<const fixed<base, fp>> in, std::span<trig_t> out) {
+    static_assert(fixed<base, fp>::is_signed, "cos only supports signed fixed types!");
+
+    std::size_t i = impl::cordic_sincos_kernel<false, true>(in, nullptr, out.data());
+    for (; i < in.size(); i++)
+        out[i] = cordic::cos(in[i]);
+}
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i32))
+void polar(std::span<const fixed<base, fp>> x, std::span<const fixed<base, fp>> y,
+           std::span<fixed<base, fp>> out_r, std::span<trig_t> out_theta) {
+    std::size_t i = impl::cordic_polar_kernel<true, true>(x, y, out_r.data(), out_theta.data());
+    for (; i < x.size(); i++)
+        cordic::polar(x[i], y[i], out_r[i], out_theta[i]);
+}
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i32))
+void atan2(std::span<const fixed<base, fp>> y, std::span<const fixed<base, fp>> x, std::span<trig_t> out) {
+    std::size_t i = impl::cordic_polar_kernel<false, true>(x, y, static_cast<fixed<base, fp>*>(nullptr), out.data());
+    for (; i < x.size(); i++)
+        out[i] = cordic::atan2(y[i], x[i]);
+}
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i32))
+void hypot(std::span<const fixed<base, fp>> x, std::span<const fixed<base, fp>> y, std::span<fixed<base, fp>> out) {
+    std::size_t i = impl::cordic_polar_kernel<true, false>(x, y, out.data(), nullptr);
+    for (; i < x.size(); i++)
+        out[i] = cordic::hypot(x[i], y[i]);
+}
+
+}
+
+}
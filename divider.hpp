@@ -0,0 +1,235 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <span>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./math_helper.hpp"
+#include "./simd.hpp"
+
+// Division without the hardware divide.
+//
+// divider<T> turns a divisor that is reused many times into a multiply and
+// a shift (Granlund-Montgomery). The quotient is exact: a / divider(b) is
+// bit-identical to a / b under every policy of T, zero divisors included.
+// 64-bit bases would need a 256-bit product, so their divider keeps using
+// operator/.
+
+namespace fxd {
+
+namespace impl {
+
+template<std::integral T>
+constexpr u64 magnitude(T value) {
+    if constexpr(std::is_signed_v<T>)
+        return (value < 0) ? u64(0) - static_cast<u64>(value) : static_cast<u64>(value);
+    else
+        return static_cast<u64>(value);
+}
+
+}
+
+template<fixed_point T>
+class divider {
+    using base = typename T::base_type;
+    using next_t = typename T::next_type;
+
+    static constexpr bool uses_magic = sizeof(base) <= sizeof(i32);
+
+    // Width of the largest numerator magnitude, |a| << frac_bits.
+    static constexpr int width = T::bits + T::frac_bits;
+
+    T d;
+    u64 ud = 0;
+    u64 magic = 0;
+    int shift = 0;
+
+public:
+    using fixed_t = T;
+
+    // With l = ceil(log2(|d|)) and m = ceil(2^(width + l) / |d|), m * |d|
+    // exceeds 2^(width + l) by less than 2^l, which keeps (n * m) >> (width + l)
+    // equal to n / |d| for every n below 2^width. m takes at most width + 1 bits.
+    constexpr explicit divider(T divisor) : d(divisor) {
+        if constexpr(uses_magic) {
+            ud = impl::magnitude(divisor.raw());
+            if (ud != 0) {
+                shift = width + std::bit_width(ud - 1);
+                magic = static_cast<u64>(((u128(1) << shift) + ud - 1) / ud);
+            }
+        }
+    }
+
+    // Forces the magic number to be computed at compile time.
+    static consteval divider constant(T divisor) {
+        return divider(divisor);
+    }
+
+    constexpr T divisor() const { return d; }
+
+    constexpr T divide(T a) const {
+        if constexpr(!uses_magic) {
+            return a / d;
+        }
+        else {
+            if (ud == 0)
+                return a / d;
+
+            const bool negative = T::is_signed && ((a < 0) != (d < 0));
+            const u64 n = impl::magnitude(a.raw()) << T::frac_bits;
+            const u64 q = static_cast<u64>((static_cast<u128>(n) * magic) >> shift);
+            const next_t quot = static_cast<next_t>(negative ? u64(0) - q : q);
+
+            using rnd = typename T::rounding_type;
+            if constexpr(impl::truncates<rnd>) {
+                return T::from_raw(impl::narrow<typename T::overflow_type, base>(quot));
+            }
+            else {
+                // Back to floor division, as round_div does.
+                const u64 r = n - q * ud;
+                const bool borrow = negative && r != 0;
+                const next_t floor_q = quot - next_t(borrow);
+                const next_t floor_r = static_cast<next_t>(borrow ? ud - r : r);
+
+                const next_t div = impl::round_floor<rnd>(floor_q, floor_r, static_cast<next_t>(ud));
+                return T::from_raw(impl::narrow<typename T::overflow_type, base>(div));
+            }
+        }
+    }
+
+    constexpr friend T operator/(T a, const divider& b) {
+        return b.divide(a);
+    }
+
+    constexpr friend T& operator/=(T& a, const divider& b) {
+        return a = b.divide(a);
+    }
+};
+
+// Approximates a / b from the rcp table and one Newton step, normalized so
+// the reciprocal keeps about 30 bits whatever the magnitude of b, then one
+// wide product. The result is within 4 ulp of a / b (3 for signed bases),
+// and division by zero saturates. 64-bit bases fall back to operator/.
+// fast_divisor below gives it operator syntax. On cores with a fast
+// hardware divide only the span version pays off.
+
+template<std::integral base, int fp>
+constexpr fixed<base, fp> fast_div(fixed<base, fp> a, fixed<base, fp> b) {
+    using fixed_t = fixed<base, fp>;
+
+    if constexpr(sizeof(base) > sizeof(i32)) {
+        return a / b;
+    }
+    else {
+        if (b == 0)
+            return (a < 0) ? fixed_t::min() : fixed_t::max();
+
+        const bool negative = fixed_t::is_signed && ((a < 0) != (b < 0));
+        const u64 ub = impl::magnitude(b.raw());
+        const int log2 = impl::ilog2(ub);
+
+        // x in [1, 2) and y close to 1 / x, both in Q1.31. Interpolating
+        // the table leaves an error below 2^-16, which one Newton step squares.
+        const u64 x = ub << (31 - log2);
+        const u32 idx = (x >> 24) & 0x7f;
+        const u64 lo = impl::rcp_lut[idx];
+        const u64 hi = (idx < 127) ? impl::rcp_lut[idx + 1] : (u64(1) << 30);
+        u64 y = lo - (((lo - hi) * ((x >> 8) & 0xffff)) >> 16);
+        y = (y * ((u64(1) << 32) - ((x * y) >> 31))) >> 31;
+
+        const u64 q = (impl::magnitude(a.raw()) * y) >> (31 + log2 - fp);
+        return fixed_t::from_raw(static_cast<base>(negative ? u64(0) - q : q));
+    }
+}
+
+// Opts a divisor into fast_div: a / fast_divisor(b) is fast_div(a, b), with
+// its error bound. Plain operator/ stays exact.
+template<std::integral base, int fp>
+class fast_divisor {
+    using T = fixed<base, fp>;
+    T d;
+
+public:
+    using fixed_t = T;
+
+    constexpr explicit fast_divisor(T divisor) : d(divisor) {}
+
+    constexpr T divisor() const { return d; }
+
+    constexpr friend T operator/(T a, fast_divisor b) {
+        return fast_div(a, b.d);
+    }
+
+    constexpr friend T& operator/=(T& a, fast_divisor b) {
+        return a = fast_div(a, b.d);
+    }
+};
+
+namespace impl {
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+// fast_div on eight lanes, bit-identical to the scalar version.
+template<int fp>
+FXD_TARGET_AVX2 inline __m256i fast_div(__m256i a, __m256i b) {
+    const __m256i zero = _mm256_cmpeq_epi32(b, _mm256_setzero_si256());
+    const __m256i negative = _mm256_srai_epi32(_mm256_xor_si256(a, b), 31);
+    const __m256i ua = _mm256_abs_epi32(a);
+    const __m256i ub = _mm256_abs_epi32(b);
+
+    // The float trick in ilog2 sees |min| as negative, which only sets
+    // bits above the valid range of 0 to 31.
+    const __m256i log2 = _mm256_and_si256(ilog2(ub), set1(31));
+    const __m256i x = _mm256_sllv_epi32(ub, _mm256_sub_epi32(set1(31), log2));
+
+    const __m256i idx = _mm256_and_si256(_mm256_srli_epi32(x, 24), set1(0x7f));
+    const __m256i last = _mm256_cmpeq_epi32(idx, set1(127));
+    const __m256i lo = gather(rcp_lut.data(), idx);
+    const __m256i hi = select(gather(rcp_lut.data(), _mm256_min_epi32(_mm256_add_epi32(idx, set1(1)), set1(127))),
+                              set1(1 << 30), last);
+
+    const __m256i frac = _mm256_and_si256(_mm256_srli_epi32(x, 8), set1(0xffff));
+    __m256i y = _mm256_sub_epi32(lo, mul<16>(_mm256_sub_epi32(lo, hi), frac));
+    y = mulu<31>(y, _mm256_sub_epi32(_mm256_setzero_si256(), mulu<31>(x, y)));
+
+    // The final shift reaches up to 62, so keep the full 64-bit products.
+    const __m256i shift = _mm256_sub_epi32(log2, set1(fp - 31));
+    const __m256i low_mask = _mm256_set1_epi64x(0xffffffff);
+    const __m256i even = _mm256_srlv_epi64(_mm256_mul_epu32(ua, y), _mm256_and_si256(shift, low_mask));
+    const __m256i odd  = _mm256_srlv_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(ua, 32), _mm256_srli_epi64(y, 32)), _mm256_srli_epi64(shift, 32));
+    const __m256i q = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+
+    const __m256i limit = select(set1(fixed<i32, fp>::max().raw()), set1(fixed<i32, fp>::min().raw()),
+                                 _mm256_cmpgt_epi32(_mm256_setzero_si256(), a));
+    return select(negate_if(q, negative), limit, zero);
+}
+
+template<int fp>
+FXD_TARGET_AVX2 std::size_t fast_div(const fixed<i32, fp>* a, const fixed<i32, fp>* b, fixed<i32, fp>* out, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        store(out + i, fast_div<fp>(load(a + i), load(b + i)));
+    return i;
+}
+
+}
+#endif
+}
+
+// Outputs must be at least as long as the inputs.
+template<std::integral base, int fp>
+void fast_div(std::span<const fixed<base, fp>> a, std::span<const fixed<base, fp>> b, std::span<fixed<base, fp>> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(std::is_same_v<base, i32>)
+        if (impl::has_avx2())
+            i = impl::avx2::fast_div<fp>(a.data(), b.data(), out.data(), a.size());
+#endif
+    for (; i < a.size(); i++)
+        out[i] = fast_div(a[i], b[i]);
+}
+
+}
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./math_helper.hpp"
+
+// Precision-tiered transcendentals.
+//
+// fxd::fast::sin<bits>(x) and friends evaluate the lowest-degree polynomial
+// that still leaves at least `bits` accurate fraction bits, where the math.hpp
+// functions always pay for close to full trig_t or exp_t precision. Without
+// `bits`, the format's own frac_bits are used, so fast::sin on a fixed8 costs
+// a degree-3 polynomial and on a fixed24 a degree-7 one.
+//
+// sin, cos and log2 are accurate to `bits` in absolute terms, exp2 relative
+// to its result. In trig_t, log_t and exp_t the top tiers reach about 25 bits
+// for sin, cos and log2 and 23 for exp2, at or above the math.hpp functions
+// for the same cost. fxd::native runs the same tiers at the caller's width.
+
+namespace fxd {
+
+namespace impl {
+
+template<int bits, int fp>
+constexpr int fast_bits = (bits > 0) ? bits : fp;
+
+// c[0] + x * (c[1] + x * (c[2] + ...)).
+template<typename T, std::size_t N>
+constexpr T horner(T x, const std::array<T, N>& c) {
+    T y = c[N - 1];
+    for (std::size_t i = N - 1; i-- > 0;)
+        y = y * x + c[i];
+    return y;
+}
+
+// Minimax polynomials, fitted with the Remez algorithm. The comment on each
+// gives the accurate bits of the polynomial alone, before rounding.
+// coefficients<T>() converts a set to a working format at compile time.
+
+template<typename T, std::size_t N>
+consteval std::array<T, N> coefficients(const std::array<double, N>& c) {
+    std::array<T, N> out{};
+    for (std::size_t i = 0; i < N; i++)
+        out[i] = c[i];
+    return out;
+}
+
+// sin(x) / x in x^2, x: [-pi/4, pi/4].
+constexpr std::array<double, 2> sin_poly3 = { 0.99903142290910307288, -0.16034401671536901990 };    // 12.7
+constexpr std::array<double, 3> sin_poly5 = { 0.99999499756163701125, -0.16660161988241484199,
+                                              0.00812155792475103416 };                             // 20.8
+constexpr std::array<double, 4> sin_poly7 = { 0.99999997541079110874, -0.16666622795443555849,
+                                              0.00833113215763192291, -0.00019420212113866576 };    // 28.7
+
+// cos(x) in x^2, x: [-pi/4, pi/4].
+constexpr std::array<double, 2> cos_poly2 = { 0.99807849900875955651, -0.47482060177589174854 };    // 9.0
+constexpr std::array<double, 3> cos_poly4 = { 0.99999003495520666362, -0.49970814035467414627,
+                                              0.04039853596612896780 };                             // 16.6
+constexpr std::array<double, 4> cos_poly6 = { 0.99999997242332316905, -0.49999856695848765575,
+                                              0.04165502688424108091, -0.00135859085099610845 };    // 25.1
+constexpr std::array<double, 5> cos_poly8 = { 0.99999999995260047125, -0.49999999615433476929,
+                                              0.04166661673920304260, -0.00138866192100566303,
+                                              0.00002437992935665532 };                             // 34.3
+
+// log2(1 + t) / t, t: [0, 1).
+constexpr std::array<double, 3> log2_poly3 = { 1.42459387704262274710, -0.58920671246678735233,
+                                               0.16538378653066421187 };                            // 10.3
+constexpr std::array<double, 4> log2_poly4 = { 1.43901469967985629062, -0.67994416175070759856,
+                                               0.32559586825536068755, -0.08476874390428118522 };   // 13.3
+constexpr std::array<double, 6> log2_poly6 = { 1.44255314500943732092, -0.71828191892267434504,
+                                               0.45827080623341992505, -0.27953813908147001621,
+                                               0.12345148770151063988, -0.02645744968118867238 };   // 18.9
+constexpr std::array<double, 8> log2_poly8 = { 1.44268988117620899914, -0.72116580597862522950,
+                                               0.47868370009680877297, -0.34730108908419632385,
+                                               0.24186478305990841142, -0.13752135436017404180,
+                                               0.05205900254277208428, -0.00930916376184997077 };   // 24.4
+constexpr std::array<double, 9> log2_poly9 = { 1.44269407149532336021, -0.72130560002858268298,
+                                               0.48026839238108515184, -0.35595165086819074984,
+                                               0.26790587395821469086, -0.18309086307360403212,
+                                               0.09822550584670626528, -0.03441618173964255956,
+                                               0.00567045912236902646 };                            // 27.1
+constexpr std::array<double, 11> log2_poly11 = { 1.44269502143898442625, -0.72134592750308612619,
+                                                 0.48085894775768744935, -0.36021352404044421069,
+                                                 0.28547083348879759290, -0.22751139918094306913,
+                                                 0.16928953576252259161, -0.10622852053049952614,
+                                                 0.04979936887746428537, -0.01490063559107158986,
+                                                 0.00208629952058770555 };                          // 31.5
+
+// (2^f - 1) / f, f: [0, 1), relative to 2^f.
+constexpr std::array<double, 2> exp2_poly2 = { 0.66596094084451207262, 0.32993240448323180036 };    // 8.9
+constexpr std::array<double, 3> exp2_poly3 = { 0.69511678641339247342, 0.22764499119524098103,
+                                               0.07706704200379568825 };                            // 13.5
+constexpr std::array<double, 4> exp2_poly4 = { 0.69304484489869655484, 0.24128020477403791522,
+                                               0.05224247418757171219, 0.01342668428953382176 };    // 18.4
+constexpr std::array<double, 5> exp2_poly5 = { 0.69315131180487976614, 0.24016445015286866371,
+                                               0.05579991310967667706, 0.00901703031589056771,
+                                               0.00186713007243873800 };                            // 23.5
+constexpr std::array<double, 6> exp2_poly6 = { 0.69314704444332453370, 0.24022930555223587223,
+                                               0.05548528061861376925, 0.00967545156699121424,
+                                               0.00124678464454486466, 0.00021612914956598307 };    // 28.9
+
+// asin(x) / x in x^2, x: [0, 0.5].
+constexpr std::array<double, 2> asin_poly3 = { 0.99810761086605115366, 0.19479527679401273388 };    // 12.3
+constexpr std::array<double, 3> asin_poly5 = { 1.00011363257195973198, 0.16323064163415473837,
+                                               0.10015336214250297742 };                            // 16.9
+constexpr std::array<double, 4> asin_poly7 = { 0.99999284086225526114, 0.16703116478397972422,
+                                               0.07006109012352680632, 0.06830640022037466619 };    // 21.2
+constexpr std::array<double, 5> asin_poly9 = { 1.00000046363121697368, 0.16663101099260249627,
+                                               0.07576182030644572352, 0.03813697701056343453,
+                                               0.05332168025922580379 };                            // 25.5
+constexpr std::array<double, 6> asin_poly11 = { 0.99999996943344593436, 0.16666997456617610451,
+                                                0.07489820221349570428, 0.04597001414011234188,
+                                                0.02218532774119505099, 0.04506130894025815736 };   // 29.6
+
+// atan(x) / x in x^2, x: [0, 1].
+constexpr std::array<double, 4> atan_poly7 = { 0.99921381258019670302, -0.32117496936041239897,
+                                               0.14626446367461259923, -0.03898651420226439263 };   // 13.6
+constexpr std::array<double, 6> atan_poly11 = { 0.99997721908029491011, -0.33262282784855112805,
+                                                0.19354037581947702851, -0.11642648129776692056,
+                                                0.05264735073436752760, -0.01171913545040301555 };  // 19.2
+constexpr std::array<double, 8> atan_poly15 = { 0.99999933557786180316, -0.33329860783131165514,
+                                                0.19946565641054864182, -0.13908629508407194253,
+                                                0.09642197237757209327, -0.05591232569170031391,
+                                                0.02186295720837951387, -0.00405456704641280440 };  // 24.7
+constexpr std::array<double, 10> atan_poly19 = { 0.99999995862988622086, -0.33333052489391268303,
+                                                 0.19994235749754554754, -0.14229929278899278167,
+                                                 0.10804181100493692735, -0.08028174818790684286,
+                                                 0.05220328116675364977, -0.02593181258995709906,
+                                                 0.00829811942170819751, -0.00124398586261290143 }; // 28.9
+
+// Approximates sin(x) for x: [-pi/4, pi/4]
+template<int bits, typename T = trig_t>
+constexpr T fast_sin(T x) {
+    const T x2 = x * x;
+    if constexpr(bits <= 11)
+        return x * horner(x2, coefficients<T>(sin_poly3));
+    else if constexpr(bits <= 19)
+        return x * horner(x2, coefficients<T>(sin_poly5));
+    else
+        return x * horner(x2, coefficients<T>(sin_poly7));
+}
+
+// Approximates cos(x) for x: [-pi/4, pi/4]
+template<int bits, typename T = trig_t>
+constexpr T fast_cos(T x) {
+    const T x2 = x * x;
+    if constexpr(bits <= 8)
+        return horner(x2, coefficients<T>(cos_poly2));
+    else if constexpr(bits <= 15)
+        return horner(x2, coefficients<T>(cos_poly4));
+    else if constexpr(bits <= 23)
+        return horner(x2, coefficients<T>(cos_poly6));
+    else
+        return horner(x2, coefficients<T>(cos_poly8));
+}
+
+// Approximates log2(1 + t) for t: [0, 1)
+template<int bits, typename T = log_t>
+constexpr T fast_log2(T t) {
+    if constexpr(bits <= 9)
+        return t * horner(t, coefficients<T>(log2_poly3));
+    else if constexpr(bits <= 12)
+        return t * horner(t, coefficients<T>(log2_poly4));
+    else if constexpr(bits <= 17)
+        return t * horner(t, coefficients<T>(log2_poly6));
+    else if constexpr(bits <= 23)
+        return t * horner(t, coefficients<T>(log2_poly8));
+    else if constexpr(bits <= 26)
+        return t * horner(t, coefficients<T>(log2_poly9));
+    else
+        return t * horner(t, coefficients<T>(log2_poly11));
+}
+
+// Approximates 2^f for f: [0, 1)
+template<int bits, typename T = exp_t>
+constexpr T fast_exp2(T f) {
+    if constexpr(bits <= 7)
+        return 1 + f * horner(f, coefficients<T>(exp2_poly2));
+    else if constexpr(bits <= 12)
+        return 1 + f * horner(f, coefficients<T>(exp2_poly3));
+    else if constexpr(bits <= 17)
+        return 1 + f * horner(f, coefficients<T>(exp2_poly4));
+    else if constexpr(bits <= 22)
+        return 1 + f * horner(f, coefficients<T>(exp2_poly5));
+    else
+        return 1 + f * horner(f, coefficients<T>(exp2_poly6));
+}
+
+// Approximates asin(x) for x: [0, 0.5]. The tiers keep a spare bit for the
+// doubling in asin's reduction of larger inputs.
+template<int bits, typename T>
+constexpr T fast_asin(T x) {
+    const T x2 = x * x;
+    if constexpr(bits <= 10)
+        return x * horner(x2, coefficients<T>(asin_poly3));
+    else if constexpr(bits <= 14)
+        return x * horner(x2, coefficients<T>(asin_poly5));
+    else if constexpr(bits <= 19)
+        return x * horner(x2, coefficients<T>(asin_poly7));
+    else if constexpr(bits <= 23)
+        return x * horner(x2, coefficients<T>(asin_poly9));
+    else
+        return x * horner(x2, coefficients<T>(asin_poly11));
+}
+
+// Approximates atan(x) for x: [0, 1]
+template<int bits, typename T>
+constexpr T fast_atan(T x) {
+    const T x2 = x * x;
+    if constexpr(bits <= 12)
+        return x * horner(x2, coefficients<T>(atan_poly7));
+    else if constexpr(bits <= 18)
+        return x * horner(x2, coefficients<T>(atan_poly11));
+    else if constexpr(bits <= 23)
+        return x * horner(x2, coefficients<T>(atan_poly15));
+    else
+        return x * horner(x2, coefficients<T>(atan_poly19));
+}
+
+// 2^(i + f), with f holding fraction bits below `one`. Saturates like exp2.
+template<int bits, typename fixed_t, typename W>
+constexpr fixed_t fast_exp2_parts(W i, W f, int one) {
+    using next_t = typename fixed_t::next_type;
+
+    if (i >= fixed_t::int_bits)
+        return fixed_t::max();
+    if (i < -fixed_t::frac_bits)
+        return fixed_t::min_frac();
+
+    const int to_exp = one - exp_t::frac_bits;
+    const exp_t x = exp_t::from_raw(static_cast<i32>((to_exp > 0) ? (f >> to_exp) : (f << -to_exp)));
+    const next_t m = fast_exp2<bits>(x).raw();
+
+    const int shift = exp_t::frac_bits - fixed_t::frac_bits - static_cast<int>(i);
+    const next_t out = (shift > 0) ? ((m + (next_t(1) << (shift - 1))) >> shift) : (m << -shift);
+    return fixed_t::from_raw(static_cast<typename fixed_t::base_type>(
+        std::clamp<next_t>(out, fixed_t::min_frac().raw(), fixed_t::max().raw())));
+}
+
+// 2^(s * c), with c in Q29.
+template<int bits, std::integral base, int fp>
+constexpr fixed<base, fp> fast_exp2_scaled(fixed<base, fp> s, i64 c) {
+    using wide_t = std::conditional_t<(sizeof(base) > sizeof(i32)), i128, i64>;
+    constexpr int one = fp + 29;
+    const wide_t y = static_cast<wide_t>(s.raw()) * c;
+    return fast_exp2_parts<bits, fixed<base, fp>>(y >> one, y & ((wide_t(1) << one) - 1), one);
+}
+
+}
+
+namespace fast {
+
+// Trigonometry
+
+template<int bits = 0, std::integral base, int fp>
+constexpr trig_t sin(fixed<base, fp> s) {
+    static_assert(fixed<base, fp>::is_signed, "sin only supports signed fixed types!");
+    constexpr int precision = impl::fast_bits<bits, fp>;
+
+    int quadrant;
+    const trig_t x = impl::reduce_half_pi(s, quadrant);
+    const trig_t out = (quadrant & 1) ? impl::fast_cos<precision>(x) : impl::fast_sin<precision>(x);
+    return ((quadrant & 2) != 0) != (s < 0) ? -out : out;
+}
+
+template<int bits = 0, std::integral base, int fp>
+constexpr trig_t cos(fixed<base, fp> s) {
+    static_assert(fixed<base, fp>::is_signed, "cos only supports signed fixed types!");
+    constexpr int precision = impl::fast_bits<bits, fp>;
+
+    int quadrant;
+    const trig_t x = impl::reduce_half_pi(s, quadrant);
+    const trig_t out = (quadrant & 1) ? impl::fast_sin<precision>(x) : impl::fast_cos<precision>(x);
+    return (quadrant == 1 || quadrant == 2) ? -out : out;
+}
+
+template<int bits = 0, std::integral base, int fp>
+constexpr void sincos(fixed<base, fp> s, trig_t& out_sin, trig_t& out_cos) {
+    static_assert(fixed<base, fp>::is_signed, "sincos only supports signed fixed types!");
+    constexpr int precision = impl::fast_bits<bits, fp>;
+
+    int quadrant;
+    const trig_t x = impl::reduce_half_pi(s, quadrant);
+    const trig_t sin_x = impl::fast_sin<precision>(x);
+    const trig_t cos_x = impl::fast_cos<precision>(x);
+
+    out_sin = (quadrant & 1) ? cos_x : sin_x;
+    out_cos = (quadrant & 1) ? sin_x : cos_x;
+    if (((quadrant & 2) != 0) != (s < 0))
+        out_sin = -out_sin;
+    if (quadrant == 1 || quadrant == 2)
+        out_cos = -out_cos;
+}
+
+// Logarithms
+
+template<int bits = 0, std::integral base, int fp>
+constexpr impl::exp_result_t<base> log2(fixed<base, fp> s) {
+    using impl::log_t;
+    using exp_t = impl::exp_result_t<base>;
+    constexpr int precision = impl::fast_bits<bits, fp>;
+
+    if (s <= 0)
+        return exp_t::min();
+
+    // The mantissa's fraction bits, as t in [0, 1).
+    const int msb = impl::ilog2(s.raw());
+    const u64 m = static_cast<u64>(s.raw());
+    const u64 t = (msb > log_t::frac_bits) ? (m >> (msb - log_t::frac_bits)) : (m << (log_t::frac_bits - msb));
+    const log_t x = log_t::from_raw(static_cast<i32>(t & ((u64(1) << log_t::frac_bits) - 1)));
+
+    return (msb - fp) + static_cast<exp_t>(impl::fast_log2<precision>(x));
+}
+
+template<int bits = 0, std::integral base, int fp>
+constexpr impl::exp_result_t<base> log(fixed<base, fp> s) {
+    return log2<bits>(s) * ln2<impl::exp_result_t<base>>;
+}
+
+template<int bits = 0, std::integral base, int fp>
+constexpr impl::exp_result_t<base> log10(fixed<base, fp> s) {
+    return log2<bits>(s) * log10_2<impl::exp_result_t<base>>;
+}
+
+// Powers
+
+template<int bits = 0, std::integral base, int fp>
+constexpr fixed<base, fp> exp2(fixed<base, fp> s) {
+    using wide_t = std::conditional_t<(sizeof(base) > sizeof(i32)), i128, i64>;
+    const wide_t raw = s.raw();
+    return impl::fast_exp2_parts<impl::fast_bits<bits, fp>, fixed<base, fp>>(
+        raw >> fp, raw & fixed<base, fp>::frac_mask, fp);
+}
+
+// The input is scaled in wide arithmetic, so no precision is lost to
+// rounding s * log2(e) back into the format.
+template<int bits = 0, std::integral base, int fp>
+constexpr fixed<base, fp> exp(fixed<base, fp> s) {
+    constexpr i64 c = 774541002;    // log2(e) in Q29
+    return impl::fast_exp2_scaled<impl::fast_bits<bits, fp>>(s, c);
+}
+
+template<int bits = 0, std::integral base, int fp>
+constexpr fixed<base, fp> exp10(fixed<base, fp> s) {
+    constexpr i64 c = 1783446566;   // log2(10) in Q29
+    return impl::fast_exp2_scaled<impl::fast_bits<bits, fp>>(s, c);
+}
+
+}
+
+}
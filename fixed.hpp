@@ -4,7 +4,9 @@
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <limits>
+#include <type_traits>
 
 namespace fxd {
 	using i8  = int8_t;
@@ -17,6 +19,14 @@ namespace fxd {
 	using u32 = uint32_t;
 	using u64 = uint64_t;
 
+	// 128-bit intermediates are used throughout, not only for 64-bit bases,
+	// so the library needs a compiler with __int128 (GCC or Clang).
+#if !defined(__SIZEOF_INT128__)
+#error "fxd requires __int128"
+#endif
+	__extension__ typedef __int128 i128;
+	__extension__ typedef unsigned __int128 u128;
+
 namespace impl {
     template<std::integral T>
     struct next_int;
@@ -37,7 +47,9 @@ namespace impl {
     };
 
     template<>
-    struct next_int<u64>;
+    struct next_int<u64> {
+        using type = u128;
+    };
 
     template<>
     struct next_int<i8> {
@@ -55,20 +67,321 @@ namespace impl {
     };
 
     template<>
-    struct next_int<i64>;
+    struct next_int<i64> {
+        using type = i128;
+    };
 
     template<std::integral T>
     using next_int_v = next_int<T>::type;
+
+    // (a << shift) / b, truncated to T like the expression on next_int_v<T>.
+    // For 64-bit T, x86-64 can divide 128 by 64 bits in one instruction as
+    // long as the quotient fits, which is far cheaper than the generic
+    // 128-bit division routine.
+    template<std::integral T>
+    constexpr T div_shifted(T a, T b, int shift) {
+        using next_t = next_int_v<T>;
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+        if constexpr(sizeof(T) == sizeof(u64)) {
+            if (!std::is_constant_evaluated()) {
+                u64 ua = static_cast<u64>(a);
+                u64 ub = static_cast<u64>(b);
+                bool negative = false;
+
+                if constexpr(std::is_signed_v<T>) {
+                    negative = (a < 0) != (b < 0);
+                    ua = (a < 0) ? -ua : ua;
+                    ub = (b < 0) ? -ub : ub;
+                }
+
+                const u128 n = static_cast<u128>(ua) << shift;
+                const u64 hi = static_cast<u64>(n >> 64);
+
+                if (hi < ub) {
+                    u64 q, r;
+                    asm("divq %4" : "=a"(q), "=d"(r) : "a"(static_cast<u64>(n)), "d"(hi), "rm"(ub));
+                    return static_cast<T>(negative ? -q : q);
+                }
+            }
+        }
+#endif
+
+        return static_cast<T>((static_cast<next_t>(a) << shift) / static_cast<next_t>(b));
+    }
 }
 
-template<std::integral base, int fp> 
+// Overflow policies, selected per type with the third template parameter of fixed.
+// They apply to + - * / << ++ -- and to the converting constructors.
+namespace overflow {
+    // Two's complement wrap-around, the behaviour of plain integer arithmetic.
+    struct wrap {};
+
+    // Clamps results to the limits of the base type.
+    struct saturate {};
+
+    // Traps on overflow in debug builds, and wraps once NDEBUG is defined.
+    struct trap {};
+}
+
+template<typename T>
+concept overflow_policy = std::same_as<T, overflow::wrap> ||
+                          std::same_as<T, overflow::saturate> ||
+                          std::same_as<T, overflow::trap>;
+
+namespace impl {
+    template<overflow_policy ovf>
+    constexpr bool checks_overflow = std::is_same_v<ovf, overflow::saturate>
+#ifndef NDEBUG
+                                  || std::is_same_v<ovf, overflow::trap>
+#endif
+                                  ;
+
+    // Picks the saturated value for an overflowed result, or traps.
+    // Kept to selects so saturation compiles without branches.
+    template<overflow_policy ovf, std::integral T>
+    constexpr T resolve(bool overflowed, T wrapped, bool upward) {
+        if constexpr(std::is_same_v<ovf, overflow::saturate>) {
+            const T limit = upward ? std::numeric_limits<T>::max() : std::numeric_limits<T>::min();
+            return overflowed ? limit : wrapped;
+        }
+        else {
+            if (overflowed)
+                __builtin_trap();
+            return wrapped;
+        }
+    }
+
+    template<overflow_policy ovf, std::integral T>
+    constexpr T add(T a, T b) {
+        if constexpr(checks_overflow<ovf>) {
+            T out;
+            const bool overflowed = __builtin_add_overflow(a, b, &out);
+            return resolve<ovf>(overflowed, out, !(b < 0));
+        }
+        else {
+            return static_cast<T>(a + b);
+        }
+    }
+
+    template<overflow_policy ovf, std::integral T>
+    constexpr T sub(T a, T b) {
+        if constexpr(checks_overflow<ovf>) {
+            T out;
+            const bool overflowed = __builtin_sub_overflow(a, b, &out);
+            return resolve<ovf>(overflowed, out, b < 0);
+        }
+        else {
+            return static_cast<T>(a - b);
+        }
+    }
+
+    template<overflow_policy ovf, std::integral T>
+    constexpr T shl(T a, int n) {
+        const T out = static_cast<T>(a << n);
+        if constexpr(checks_overflow<ovf>) {
+            const bool overflowed = static_cast<T>(out >> n) != a;
+            return resolve<ovf>(overflowed, out, !(a < 0));
+        }
+        else {
+            return out;
+        }
+    }
+
+    // Narrows a wider intermediate, such as a next_t product, into T.
+    template<overflow_policy ovf, std::integral T, typename W>
+    constexpr T narrow(W value) {
+        if constexpr(checks_overflow<ovf>) {
+            // Compare in a type that holds both W and the limits of T.
+            using cmp_s = std::conditional_t<(sizeof(W) < sizeof(i64)), i64, i128>;
+            using cmp_u = std::conditional_t<(sizeof(W) < sizeof(i64)), u64, u128>;
+            constexpr bool signed_w = static_cast<W>(-1) < static_cast<W>(0);
+
+            const bool negative = signed_w && value < static_cast<W>(0);
+            const bool under = negative &&
+                static_cast<cmp_s>(value) < static_cast<cmp_s>(std::numeric_limits<T>::min());
+            const bool over = !negative &&
+                static_cast<cmp_u>(value) > static_cast<cmp_u>(std::numeric_limits<T>::max());
+
+            return resolve<ovf>(under || over, static_cast<T>(value), over);
+        }
+        else {
+            return static_cast<T>(value);
+        }
+    }
+
+    // Converts an already scaled floating point value, truncating towards zero.
+    // Saturation maps NaN to zero, and the trap policy traps on it.
+    template<overflow_policy ovf, std::integral T, std::floating_point F>
+    constexpr T from_float(F value) {
+        if constexpr(checks_overflow<ovf>) {
+            constexpr F hi = static_cast<F>(std::numeric_limits<T>::max() / 2 + 1) * 2;
+            constexpr F lo = static_cast<F>(std::numeric_limits<T>::min());
+            const bool over = value >= hi;
+            const bool under = value < lo;
+            const bool nan = value != value;
+            const T out = (over || under || nan) ? T(0) : static_cast<T>(value);
+            const bool trap_nan = nan && std::is_same_v<ovf, overflow::trap>;
+            return resolve<ovf>(over || under || trap_nan, out, over);
+        }
+        else {
+            return static_cast<T>(value);
+        }
+    }
+}
+
+// Rounding policies, selected per type with the fourth template parameter of fixed.
+// They apply to *, /, the float constructor and fixed-to-fixed conversions.
+namespace rounding {
+    // Drops the extra bits: * floors, while / and the float constructor
+    // round towards zero. This is the behaviour of the plain operators.
+    struct truncate {};
+
+    // Rounds to nearest, with ties towards positive infinity.
+    struct half_up {};
+
+    // Rounds to nearest, with ties to the even neighbour.
+    struct half_even {};
+
+    // Rounds up with probability equal to the discarded fraction.
+    // source() is called once per rounding and must return random unsigned bits,
+    // e.g. stochastic<+[] { return u64(rng()); }>.
+    template<auto source>
+    struct stochastic {};
+}
+
+namespace impl {
+    template<typename T>
+    constexpr bool is_stochastic = false;
+
+    template<auto source>
+    constexpr bool is_stochastic<rounding::stochastic<source>> = true;
+
+    template<auto source>
+    constexpr u64 random_bits(rounding::stochastic<source>) {
+        return static_cast<u64>(source());
+    }
+}
+
+template<typename T>
+concept rounding_policy = std::same_as<T, rounding::truncate> ||
+                          std::same_as<T, rounding::half_up> ||
+                          std::same_as<T, rounding::half_even> ||
+                          impl::is_stochastic<T>;
+
+namespace impl {
+    template<rounding_policy rnd>
+    constexpr bool truncates = std::is_same_v<rnd, rounding::truncate>;
+
+    // value / 2^shift rounded by the policy, for shift >= 1.
+    template<rounding_policy rnd, typename W>
+    constexpr W round_shift(W value, int shift) {
+        const W mask = (W(1) << shift) - 1;
+        const W half = W(1) << (shift - 1);
+
+        if constexpr(std::is_same_v<rnd, rounding::half_up>) {
+            return (value + half) >> shift;
+        }
+        else if constexpr(std::is_same_v<rnd, rounding::half_even>) {
+            // Adding the low bit of the quotient breaks ties towards even.
+            const W q = value >> shift;
+            return q + W(((value & mask) + (q & 1)) > half);
+        }
+        else if constexpr(is_stochastic<rnd>) {
+            return (value + (static_cast<W>(random_bits(rnd{})) & mask)) >> shift;
+        }
+        else {
+            return value >> shift;
+        }
+    }
+
+    // Rounds the floor quotient q of some n / d by the policy, given the
+    // remainder 0 <= r < d. Not for truncate, which needs no remainder.
+    template<rounding_policy rnd, typename W>
+    constexpr W round_floor(W q, W r, W d) {
+        if constexpr(std::is_same_v<rnd, rounding::half_up>) {
+            return q + W((r << 1) >= d);
+        }
+        else if constexpr(std::is_same_v<rnd, rounding::half_even>) {
+            return q + W(((r << 1) + (q & 1)) > d);
+        }
+        else {
+            const u128 pick = (static_cast<u128>(random_bits(rnd{})) * static_cast<u128>(d)) >> 64;
+            return q + W(static_cast<W>(pick) < r);
+        }
+    }
+
+    // n / d rounded by the policy.
+    template<rounding_policy rnd, typename W>
+    constexpr W round_div(W n, W d) {
+        if constexpr(truncates<rnd>) {
+            return n / d;
+        }
+        else {
+            constexpr bool signed_w = static_cast<W>(-1) < static_cast<W>(0);
+            if constexpr(signed_w) {
+                if (d < 0) {
+                    n = -n;
+                    d = -d;
+                }
+            }
+
+            // Floor division, leaving 0 <= r < d.
+            W q = n / d;
+            W r = n % d;
+            if constexpr(signed_w) {
+                const bool borrow = r < 0;
+                q -= W(borrow);
+                r += borrow ? d : W(0);
+            }
+
+            return round_floor<rnd>(q, r, d);
+        }
+    }
+
+    // Rounds a scaled floating point value to an integral value by the policy.
+    template<rounding_policy rnd, std::floating_point F>
+    constexpr F round_float(F value) {
+        if constexpr(truncates<rnd>) {
+            return value;
+        }
+        else {
+            // Values this large are already integral, and NaN passes through.
+            constexpr int digits = std::numeric_limits<F>::digits - 1;
+            constexpr F big = static_cast<F>(u64(1) << (digits < 62 ? digits : 62));
+            if (!(value < big && value > -big))
+                return value;
+
+            F f = static_cast<F>(static_cast<i64>(value));
+            f -= (f > value) ? F(1) : F(0);
+            const F d = value - f;
+
+            if constexpr(std::is_same_v<rnd, rounding::half_up>) {
+                return f + ((d >= F(0.5)) ? F(1) : F(0));
+            }
+            else if constexpr(std::is_same_v<rnd, rounding::half_even>) {
+                const bool odd = static_cast<i64>(f) & 1;
+                return f + ((d > F(0.5) || (d == F(0.5) && odd)) ? F(1) : F(0));
+            }
+            else {
+                const F pick = static_cast<F>(random_bits(rnd{}) >> 11) * F(0x1p-53);
+                return f + ((pick < d) ? F(1) : F(0));
+            }
+        }
+    }
+}
+
+template<std::integral base, int fp, overflow_policy ovf = overflow::wrap, rounding_policy rnd = rounding::truncate>
 class fixed {
     static constexpr base one = base(1);
     using next_t = impl::next_int_v<base>;
     base _data;
 public:
-    using fixed_t = fixed<base, fp>;
+    using fixed_t = fixed<base, fp, ovf, rnd>;
     using base_type = base;
+    using overflow_type = ovf;
+    using rounding_type = rnd;
+    using next_type = next_t;
     static constexpr bool is_signed = std::is_signed_v<base>;
     static constexpr int bits = sizeof(base) * CHAR_BIT;
     static constexpr int frac_bits = fp;
@@ -79,7 +392,7 @@ public:
 
     static constexpr base max_int = (one << int_bits) - 1;
     static constexpr base frac_mask = (one << fp) - 1;
-    static constexpr base int_mask = static_cast<base>( (~frac_mask) ^ (is_signed << (bits - 1)) );
+    static constexpr base int_mask = static_cast<base>( (~frac_mask) ^ (static_cast<base>(is_signed) << (bits - 1)) );
 
     template<std::integral T>
     static constexpr fixed_t from_raw(T b) {
@@ -88,6 +401,12 @@ public:
         return out;
     }
 
+    // Builds a value from an unshifted product of raws, or a sum of them,
+    // shifting and applying the rounding and overflow policies once.
+    static constexpr fixed_t from_product(next_t value) {
+        return from_raw(impl::narrow<ovf, base>(impl::round_shift<rnd>(value, fp)));
+    }
+
     static constexpr fixed_t max_frac() { 
         return from_raw(frac_mask); 
     };
@@ -111,7 +430,7 @@ public:
     constexpr fixed& operator=(fixed_t&&) = default;
 
     constexpr fixed(base value) {
-        _data = value << fp;
+        _data = impl::shl<ovf>(value, fp);
     }
 
     constexpr base raw() const {
@@ -120,12 +439,12 @@ public:
 
     template<std::floating_point T>
     constexpr fixed(T value) {
-        _data = static_cast<base>(value * T(one << fp));
+        _data = impl::from_float<ovf, base>(impl::round_float<rnd>(value * T(one << fp)));
     }
     
-    template<std::integral other_base, int other_fp>
-    constexpr fixed(fixed<other_base, other_fp> other) {
-        *this = other.operator fixed<base, fp>();
+    template<std::integral other_base, int other_fp, overflow_policy other_ovf, rounding_policy other_rnd>
+    constexpr fixed(fixed<other_base, other_fp, other_ovf, other_rnd> other) {
+        *this = other.operator fixed_t();
     }
 
     constexpr fixed frac() const { 
@@ -151,60 +470,68 @@ public:
             return static_cast<T>(_data >> fp);
     }
 
-    template<std::integral other_base, int other_fp>
-    constexpr explicit operator fixed<other_base, other_fp>() const {
-        using other_t = fixed<other_base, other_fp>;
+    // Overflow and rounding follow the policies of the destination type.
+    template<std::integral other_base, int other_fp, overflow_policy other_ovf, rounding_policy other_rnd>
+    constexpr explicit operator fixed<other_base, other_fp, other_ovf, other_rnd>() const {
+        using other_t = fixed<other_base, other_fp, other_ovf, other_rnd>;
 
         if constexpr(other_fp > fp) {
             next_t data = static_cast<next_t>(_data);
-            return other_t::from_raw(data << (other_fp - fp));
+            return other_t::from_raw(impl::narrow<other_ovf, other_base>(data << (other_fp - fp)));
+        }
+        else if constexpr(other_fp < fp && !impl::truncates<other_rnd>) {
+            const next_t data = impl::round_shift<other_rnd>(static_cast<next_t>(_data), fp - other_fp);
+            return other_t::from_raw(impl::narrow<other_ovf, other_base>(data));
         }
         else if constexpr(other_fp < fp) {
             if constexpr(other_t::is_signed) {
-                return other_t::from_raw(_data / (one << (fp - other_fp)));
+                return other_t::from_raw(impl::narrow<other_ovf, other_base>(_data / (one << (fp - other_fp))));
             }
             else {
-                return other_t::from_raw(_data >> (fp - other_fp));
+                return other_t::from_raw(impl::narrow<other_ovf, other_base>(_data >> (fp - other_fp)));
             }
         }
         else {
-            return other_t::from_raw(_data);
+            return other_t::from_raw(impl::narrow<other_ovf, other_base>(_data));
         }
     }
 
-    constexpr fixed_t operator-() const { return from_raw(-_data); }
+    // Negating min() overflows, so the checked policies go through sub.
+    constexpr fixed_t operator-() const {
+        if constexpr(impl::checks_overflow<ovf>)
+            return from_raw(impl::sub<ovf>(base(0), _data));
+        else
+            return from_raw(-_data);
+    }
     constexpr fixed_t operator~() const { return from_raw(~_data); }
 
-    constexpr fixed_t& operator++()    { _data += one << fp; return *this; }
-    constexpr fixed_t& operator++(int) { _data += one << fp; return *this; }
-    constexpr fixed_t& operator--()    { _data -= one << fp; return *this; }
-    constexpr fixed_t& operator--(int) { _data -= one << fp; return *this; }
+    constexpr fixed_t& operator++()    { _data = impl::add<ovf>(_data, base(one << fp)); return *this; }
+    constexpr fixed_t& operator++(int) { _data = impl::add<ovf>(_data, base(one << fp)); return *this; }
+    constexpr fixed_t& operator--()    { _data = impl::sub<ovf>(_data, base(one << fp)); return *this; }
+    constexpr fixed_t& operator--(int) { _data = impl::sub<ovf>(_data, base(one << fp)); return *this; }
 
     constexpr fixed_t& operator+=(const fixed_t other) {
-        _data += other._data;
+        _data = impl::add<ovf>(_data, other._data);
         return *this;
     }
 
     constexpr fixed_t& operator-=(const fixed_t other) {
-        _data -= other._data;
+        _data = impl::sub<ovf>(_data, other._data);
         return *this;
     }
 
     constexpr fixed_t& operator*=(const fixed_t other) {
-        const next_t mul = static_cast<next_t>(_data) * static_cast<next_t>(other._data);
-        _data = static_cast<base>(mul >> fp);
+        *this = *this * other;
         return *this;
     }
 
     constexpr fixed_t& operator/=(const fixed_t other) {
-        const next_t div = (static_cast<next_t>(_data) << fp) / static_cast<next_t>(other._data);
-        _data = static_cast<base>(div);
+        *this = *this / other;
         return *this;
     }
 
     constexpr fixed_t& operator%=(const fixed_t other) {
-        const next_t rem = static_cast<next_t>(_data) % static_cast<next_t>(other._data);
-        _data = static_cast<base>(rem);
+        *this = *this % other;
         return *this;
     }
 
@@ -224,7 +551,7 @@ public:
     }
 
     constexpr fixed_t& operator<<=(const int other) {
-        _data <<= other;
+        _data = impl::shl<ovf>(_data, other);
         return *this;
     }
 
@@ -234,26 +561,50 @@ public:
     }
 
     constexpr friend fixed_t operator+(const fixed_t a, const fixed_t b) {
-        return from_raw(a._data + b._data);
+        return from_raw(impl::add<ovf>(a._data, b._data));
     }
 
     constexpr friend fixed_t operator-(const fixed_t a, const fixed_t b) {
-        return from_raw(a._data - b._data);
+        return from_raw(impl::sub<ovf>(a._data, b._data));
     }
 
     constexpr friend fixed_t operator*(const fixed_t a, const fixed_t b) {
         const next_t mul = static_cast<next_t>(a._data) * static_cast<next_t>(b._data);
-        return from_raw(static_cast<base>(mul >> fp));
+        return from_product(mul);
     }
 
     constexpr friend fixed_t operator/(const fixed_t a, const fixed_t b) {
-        const next_t div = (static_cast<next_t>(a._data) << fp) / static_cast<next_t>(b._data);
-        return from_raw(static_cast<base>(div));
+        if constexpr(impl::checks_overflow<ovf> || !impl::truncates<rnd>) {
+            if constexpr(impl::checks_overflow<ovf>) {
+                if (b._data == 0)
+                    return from_raw(impl::resolve<ovf>(true, base(0), !(a._data < 0)));
+            }
+
+            const next_t div = impl::round_div<rnd>(static_cast<next_t>(a._data) << fp, static_cast<next_t>(b._data));
+            return from_raw(impl::narrow<ovf, base>(div));
+        }
+        else if constexpr(bits == 64) {
+            return from_raw(impl::div_shifted(a._data, b._data, fp));
+        }
+        else {
+            const next_t div = (static_cast<next_t>(a._data) << fp) / static_cast<next_t>(b._data);
+            return from_raw(static_cast<base>(div));
+        }
     }
 
     constexpr friend fixed_t operator%(const fixed_t a, const fixed_t b) {
-        const next_t rem = static_cast<next_t>(a._data) % static_cast<next_t>(b._data);
-        return from_raw(static_cast<base>(rem));
+        if constexpr(bits == 64) {
+            // The remainder always fits, so skip the 128-bit division.
+            // Only min % -1 would trap, and its remainder is zero.
+            if constexpr(is_signed)
+                return from_raw((b._data == -1) ? base(0) : base(a._data % b._data));
+            else
+                return from_raw(a._data % b._data);
+        }
+        else {
+            const next_t rem = static_cast<next_t>(a._data) % static_cast<next_t>(b._data);
+            return from_raw(static_cast<base>(rem));
+        }
     }
 
     constexpr friend fixed_t operator&(const fixed_t a, const base b) {
@@ -273,7 +624,7 @@ public:
     }
 
     constexpr friend fixed_t operator<<(const fixed_t a, const int b) {
-        return from_raw(a._data << b);
+        return from_raw(impl::shl<ovf>(a._data, b));
     }
 
     constexpr friend bool operator>(const fixed_t a, const fixed_t b) {
@@ -326,9 +677,9 @@ using frac_t    = fixed<i32, 28>; // 1 sign bit, 3 integer bits, 28 fraction bit
 
 namespace std {
 
-template<std::integral base, int fp>
-struct hash<fxd::fixed<base, fp>> {
-    std::size_t operator()(const fxd::fixed<base, fp>& x) const {
+template<std::integral base, int fp, fxd::overflow_policy ovf, fxd::rounding_policy rnd>
+struct hash<fxd::fixed<base, fp, ovf, rnd>> {
+    std::size_t operator()(const fxd::fixed<base, fp, ovf, rnd>& x) const {
         return std::hash<base>()(x.raw());
     }
 };
@@ -0,0 +1,465 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./simd.hpp"
+#include "./accumulator.hpp"
+
+// Matrix products over dense, row-major spans of fixed values.
+//
+// gemm(a, b, c, m, n, k) sets c (m x n) to a (m x k) times b (k x n), and
+// gemv(a, x, y, m, k) sets y (m) to a (m x k) times x (k). The formats may
+// differ, e.g. hfixed12 weights with fixed16 activations. Products are kept
+// unshifted, with the fraction bits of both inputs, and summed in the next
+// wider integer of the wider input, but never in less than 64 bits. Each
+// output is then shifted, rounded and narrowed once, with its own format's
+// policies. 16-bit inputs cannot outgrow the sum; 32-bit ones wrap, as
+// accumulator does, once the sum passes 2^63.
+//
+// gemm packs blocks of b and a into panels zero padded to whole tiles, and
+// a micro-kernel keeps one tile of sums in registers over each block of k.
+// Longer k carries the sums of one mc x nc block of c between blocks of k,
+// and each tile is rounded into c straight after its last block. With AVX2,
+// signed 16-bit inputs use pmaddwd on pairs of k into 32-bit partial sums,
+// added into the 64-bit tile before any of them can overflow. How often
+// depends on the largest inputs, and inputs large enough to overflow a
+// single pmaddwd take the 32-bit path instead: other signed inputs up to 32
+// bits use 32 x 32 -> 64-bit multiplies. Every path adds with wrap-around
+// in the same integer, so results do not depend on the kernel, the
+// blocking or the thread count.
+//
+// threads > 1 splits the rows of the output across std::threads, each with
+// its own buffers. Build with -pthread.
+
+namespace fxd {
+
+namespace impl {
+
+template<fixed_point TA, fixed_point TB>
+using product_base_t = std::conditional_t<(sizeof(typename TA::base_type) >= sizeof(typename TB::base_type)),
+                                          typename TA::base_type, typename TB::base_type>;
+
+// The integer summing products of TA and TB, as accumulator's.
+template<fixed_point TA, fixed_point TB>
+using product_wide_t = sum_int_t<product_base_t<TA, TB>>;
+
+// Micro-kernels add a panel of mr rows of a times a panel of nr columns of b
+// into an mr x nr tile of wide sums, ldt apart, or overwrite it when
+// accumulate is false. Panels hold `group` consecutive k per row or column,
+// then the next group.
+template<typename L, typename W>
+struct scalar_kernel {
+    using lane = L;
+    using wide = W;
+    static constexpr std::size_t mr = 4, nr = 4, group = 1;
+
+    static void run(std::size_t kc, const L* a, const L* b, W* tile, std::size_t ldt, bool accumulate) {
+        W sum[mr][nr];
+        for (std::size_t r = 0; r < mr; r++)
+            for (std::size_t j = 0; j < nr; j++)
+                sum[r][j] = accumulate ? tile[r * ldt + j] : W(0);
+
+        for (std::size_t p = 0; p < kc; p++, a += mr, b += nr)
+            for (std::size_t r = 0; r < mr; r++)
+                for (std::size_t j = 0; j < nr; j++)
+                    sum[r][j] = wrapping_add(sum[r][j], static_cast<W>(W(a[r]) * W(b[j])));
+
+        for (std::size_t r = 0; r < mr; r++)
+            for (std::size_t j = 0; j < nr; j++)
+                tile[r * ldt + j] = sum[r][j];
+    }
+};
+
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+// Adds eight i32 lanes into eight i64 sums at p.
+FXD_TARGET_AVX2 inline void add_wide(i64* p, __m256i v) {
+    store(p, _mm256_add_epi64(load(p), _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v))));
+    store(p + 4, _mm256_add_epi64(load(p + 4), _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1))));
+}
+
+// Signed 16-bit lanes. Each pmaddwd multiplies a pair of k from a row of a,
+// broadcast, with the same pair from eight columns of b. The 32-bit sums
+// are added into the 64-bit tile every `interval` pairs.
+struct madd16_kernel {
+    using lane = i16;
+    using wide = i64;
+    static constexpr std::size_t mr = 6, nr = 16, group = 2;
+
+    std::size_t interval;
+
+    FXD_TARGET_AVX2 void run(std::size_t kc, const i16* a, const i16* b, i64* tile, std::size_t ldt, bool accumulate) const {
+        if (!accumulate)
+            for (std::size_t r = 0; r < mr; r++)
+                std::fill_n(tile + r * ldt, nr, i64(0));
+
+        const std::size_t steps = (kc + 1) / 2;
+        for (std::size_t s0 = 0; s0 < steps; s0 += interval) {
+            __m256i sum[mr][2];
+            for (std::size_t r = 0; r < mr; r++)
+                sum[r][0] = sum[r][1] = _mm256_setzero_si256();
+
+            for (std::size_t s = s0; s < std::min(steps, s0 + interval); s++, a += mr * group, b += nr * group) {
+                const __m256i b0 = load(b);
+                const __m256i b1 = load(b + 16);
+                for (std::size_t r = 0; r < mr; r++) {
+                    i32 pair;
+                    std::memcpy(&pair, a + r * group, sizeof(pair));
+                    const __m256i ar = _mm256_set1_epi32(pair);
+                    sum[r][0] = _mm256_add_epi32(sum[r][0], _mm256_madd_epi16(ar, b0));
+                    sum[r][1] = _mm256_add_epi32(sum[r][1], _mm256_madd_epi16(ar, b1));
+                }
+            }
+
+            for (std::size_t r = 0; r < mr; r++) {
+                add_wide(tile + r * ldt, sum[r][0]);
+                add_wide(tile + r * ldt + 8, sum[r][1]);
+            }
+        }
+    }
+};
+
+// Signed lanes of up to 32 bits, summed in 64. pmuldq takes the low half of
+// each 64-bit lane, so b is sign-extended four columns at a time.
+struct mul32_kernel {
+    using lane = i32;
+    using wide = i64;
+    static constexpr std::size_t mr = 6, nr = 8, group = 1;
+
+    FXD_TARGET_AVX2 static void run(std::size_t kc, const i32* a, const i32* b, i64* tile, std::size_t ldt, bool accumulate) {
+        __m256i sum[mr][2];
+        for (std::size_t r = 0; r < mr; r++) {
+            sum[r][0] = accumulate ? load(tile + r * ldt) : _mm256_setzero_si256();
+            sum[r][1] = accumulate ? load(tile + r * ldt + 4) : _mm256_setzero_si256();
+        }
+
+        for (std::size_t p = 0; p < kc; p++, a += mr, b += nr) {
+            const __m256i b0 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+            const __m256i b1 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 4)));
+            for (std::size_t r = 0; r < mr; r++) {
+                const __m256i ar = _mm256_set1_epi32(a[r]);
+                sum[r][0] = _mm256_add_epi64(sum[r][0], _mm256_mul_epi32(ar, b0));
+                sum[r][1] = _mm256_add_epi64(sum[r][1], _mm256_mul_epi32(ar, b1));
+            }
+        }
+
+        for (std::size_t r = 0; r < mr; r++) {
+            store(tile + r * ldt, sum[r][0]);
+            store(tile + r * ldt + 4, sum[r][1]);
+        }
+    }
+};
+
+}
+#endif
+
+constexpr std::size_t round_up(std::size_t n, std::size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+// rows x kc of a, lda apart, as panels of K::mr rows.
+template<typename K, fixed_point T>
+void pack_a(const T* a, std::size_t lda, std::size_t rows, std::size_t kc, typename K::lane* out) {
+    using lane = typename K::lane;
+    const std::size_t kp = round_up(kc, K::group);
+    for (std::size_t i0 = 0; i0 < rows; i0 += K::mr)
+        for (std::size_t p0 = 0; p0 < kp; p0 += K::group)
+            for (std::size_t r = 0; r < K::mr; r++)
+                for (std::size_t g = 0; g < K::group; g++) {
+                    const std::size_t i = i0 + r, p = p0 + g;
+                    *out++ = (i < rows && p < kc) ? static_cast<lane>(a[i * lda + p].raw()) : lane(0);
+                }
+}
+
+// kc x cols of b, ldb apart, as panels of K::nr columns.
+template<typename K, fixed_point T>
+void pack_b(const T* b, std::size_t ldb, std::size_t kc, std::size_t cols, typename K::lane* out) {
+    using lane = typename K::lane;
+    const std::size_t kp = round_up(kc, K::group);
+    for (std::size_t j0 = 0; j0 < cols; j0 += K::nr)
+        for (std::size_t p0 = 0; p0 < kp; p0 += K::group)
+            for (std::size_t j = 0; j < K::nr; j++)
+                for (std::size_t g = 0; g < K::group; g++) {
+                    const std::size_t col = j0 + j, p = p0 + g;
+                    *out++ = (col < cols && p < kc) ? static_cast<lane>(b[p * ldb + col].raw()) : lane(0);
+                }
+}
+
+// Block sizes: a block of a (mc x kc) stays in L2 while each panel of b
+// (kc x nr) is reused from L1 across it.
+constexpr std::size_t gemm_kc = 256;
+constexpr std::size_t gemm_mc = 120;
+constexpr std::size_t gemm_nc = 256;
+
+// c = a * b for m rows of a and c, with row strides k and n.
+template<typename K, fixed_point TA, fixed_point TB, fixed_point TC>
+void gemm_blocked(const K& kernel, const TA* a, const TB* b, TC* c, std::size_t m, std::size_t n, std::size_t k) {
+    using lane = typename K::lane;
+    using W = typename K::wide;
+    constexpr int from = TA::frac_bits + TB::frac_bits;
+    static_assert(gemm_mc % K::mr == 0 && gemm_nc % K::nr == 0 && gemm_kc % K::group == 0);
+
+    const std::size_t kc_max = round_up(std::min(k, gemm_kc), K::group);
+    const std::size_t mc_max = round_up(std::min(m, gemm_mc), K::mr);
+    const std::size_t nc_max = round_up(std::min(n, gemm_nc), K::nr);
+    std::vector<lane> pa(mc_max * kc_max);
+    std::vector<lane> pb(nc_max * kc_max);
+
+    // Sums cross blocks of k only when k is longer than one block, and
+    // then only for the current mc x nc block of c. Each block of b is then
+    // packed once per block of rows, which a single block of rows avoids.
+    const bool carry = k > gemm_kc;
+    std::vector<W> wide(carry ? mc_max * nc_max : K::mr * K::nr);
+
+    for (std::size_t jc = 0; jc < n; jc += gemm_nc) {
+        const std::size_t nc = std::min(gemm_nc, n - jc);
+        for (std::size_t ic = 0; ic < m; ic += gemm_mc) {
+            const std::size_t mc = std::min(gemm_mc, m - ic);
+            for (std::size_t pc = 0; pc < k; pc += gemm_kc) {
+                const std::size_t kc = std::min(gemm_kc, k - pc);
+                const std::size_t kp = round_up(kc, K::group);
+                const bool last = pc + kc == k;
+                pack_b<K>(b + pc * n + jc, n, kc, nc, pb.data());
+                pack_a<K>(a + ic * k + pc, k, mc, kc, pa.data());
+
+                for (std::size_t jr = 0; jr < nc; jr += K::nr) {
+                    for (std::size_t ir = 0; ir < mc; ir += K::mr) {
+                        W* tile = carry ? wide.data() + ir * nc_max + jr : wide.data();
+                        const std::size_t ldt = carry ? nc_max : K::nr;
+                        kernel.run(kc, pa.data() + ir * kp, pb.data() + jr * kp, tile, ldt, pc > 0);
+
+                        if (last) {
+                            const std::size_t rows = std::min(K::mr, mc - ir);
+                            const std::size_t cols = std::min(K::nr, nc - jr);
+                            for (std::size_t r = 0; r < rows; r++) {
+                                TC* out = c + (ic + ir + r) * n + jc + jr;
+                                for (std::size_t j = 0; j < cols; j++)
+                                    out[j] = from_wide<TC, from>(tile[r * ldt + j]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// The largest |raw| of n values.
+template<fixed_point T>
+u32 max_abs(const T* x, std::size_t n) {
+    u32 out = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        const i32 v = x[i].raw();
+        out = std::max(out, static_cast<u32>((v < 0) ? -v : v));
+    }
+    return out;
+}
+
+// How many pmaddwd results, each at most 2 * max_a * max_b, a 32-bit lane
+// can sum without overflowing. 0 when a single one can overflow.
+inline std::size_t madd16_interval(u32 max_a, u32 max_b) {
+    const u64 pair = 2 * u64(max_a) * u64(max_b);
+    if (pair == 0)
+        return std::size_t(1) << 30;
+    return static_cast<std::size_t>(u64(std::numeric_limits<i32>::max()) / pair);
+}
+
+template<fixed_point TA, fixed_point TB>
+constexpr bool signed_product = TA::is_signed && TB::is_signed;
+
+template<fixed_point TA, fixed_point TB>
+constexpr bool has_madd16 = signed_product<TA, TB> && sizeof(product_base_t<TA, TB>) <= sizeof(i16);
+
+template<fixed_point TA, fixed_point TB>
+constexpr bool has_mul32 = signed_product<TA, TB> && sizeof(product_base_t<TA, TB>) <= sizeof(i32);
+
+template<fixed_point TA, fixed_point TB, fixed_point TC>
+void gemm_rows(const TA* a, const TB* b, TC* c, std::size_t m, std::size_t n, std::size_t k) {
+#ifdef FXD_X86_SIMD
+    if constexpr(has_madd16<TA, TB>) {
+        if (has_avx2()) {
+            const std::size_t interval = madd16_interval(max_abs(a, m * k), max_abs(b, k * n));
+            if (interval > 0)
+                return gemm_blocked(avx2::madd16_kernel{ interval }, a, b, c, m, n, k);
+        }
+    }
+    if constexpr(has_mul32<TA, TB>) {
+        if (has_avx2())
+            return gemm_blocked(avx2::mul32_kernel{}, a, b, c, m, n, k);
+    }
+#endif
+    gemm_blocked(scalar_kernel<product_base_t<TA, TB>, product_wide_t<TA, TB>>{}, a, b, c, m, n, k);
+}
+
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+FXD_TARGET_AVX2 inline __m256i load_epi32(const i16* p) {
+    return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+FXD_TARGET_AVX2 inline __m256i load_epi32(const i32* p) {
+    return load(p);
+}
+
+// Sums of rows of a times x, for R rows lda apart, over whole blocks of
+// sixteen. The 32-bit lanes are added into 64-bit sums every `interval`
+// blocks. Returns how many k were processed.
+template<std::size_t R>
+FXD_TARGET_AVX2 std::size_t gemv_madd16(const i16* a, std::size_t lda, const i16* x, std::size_t k,
+                                        std::size_t interval, i64* out) {
+    __m256i wide[R];
+    for (std::size_t r = 0; r < R; r++)
+        wide[r] = _mm256_setzero_si256();
+
+    std::size_t p = 0;
+    while (p + 16 <= k) {
+        __m256i sum[R];
+        for (std::size_t r = 0; r < R; r++)
+            sum[r] = _mm256_setzero_si256();
+
+        for (std::size_t i = 0; i < interval && p + 16 <= k; i++, p += 16) {
+            const __m256i xv = load(x + p);
+            for (std::size_t r = 0; r < R; r++)
+                sum[r] = _mm256_add_epi32(sum[r], _mm256_madd_epi16(load(a + r * lda + p), xv));
+        }
+        for (std::size_t r = 0; r < R; r++) {
+            wide[r] = _mm256_add_epi64(wide[r], _mm256_cvtepi32_epi64(_mm256_castsi256_si128(sum[r])));
+            wide[r] = _mm256_add_epi64(wide[r], _mm256_cvtepi32_epi64(_mm256_extracti128_si256(sum[r], 1)));
+        }
+    }
+    for (std::size_t r = 0; r < R; r++)
+        out[r] = hsum_epi64(wide[r]);
+    return p;
+}
+
+// As gemv_madd16 in 64-bit sums, over whole blocks of eight.
+template<std::size_t R, typename A, typename X>
+FXD_TARGET_AVX2 std::size_t gemv_mul32(const A* a, std::size_t lda, const X* x, std::size_t k, i64* out) {
+    __m256i sum[R];
+    for (std::size_t r = 0; r < R; r++)
+        sum[r] = _mm256_setzero_si256();
+
+    std::size_t p = 0;
+    for (; p + 8 <= k; p += 8) {
+        const __m256i xv = load_epi32(x + p);
+        const __m256i x_odd = _mm256_srli_epi64(xv, 32);
+        for (std::size_t r = 0; r < R; r++) {
+            const __m256i av = load_epi32(a + r * lda + p);
+            sum[r] = _mm256_add_epi64(sum[r], _mm256_mul_epi32(av, xv));
+            sum[r] = _mm256_add_epi64(sum[r], _mm256_mul_epi32(_mm256_srli_epi64(av, 32), x_odd));
+        }
+    }
+    for (std::size_t r = 0; r < R; r++)
+        out[r] = hsum_epi64(sum[r]);
+    return p;
+}
+
+}
+#endif
+
+// y = a * x for R rows of a and y. interval is madd16_interval for x and
+// any 16-bit row.
+template<std::size_t R, fixed_point TA, fixed_point TB, fixed_point TY>
+void gemv_block(const TA* a, const TB* x, TY* y, std::size_t k, [[maybe_unused]] std::size_t interval) {
+    using W = product_wide_t<TA, TB>;
+    constexpr int from = TA::frac_bits + TB::frac_bits;
+
+    W sum[R] = {};
+    std::size_t p = 0;
+#ifdef FXD_X86_SIMD
+    using ba = typename TA::base_type;
+    using bb = typename TB::base_type;
+    constexpr bool both_i16 = std::is_same_v<ba, i16> && std::is_same_v<bb, i16>;
+    if constexpr(both_i16) {
+        if (has_avx2() && interval > 0)
+            p = avx2::gemv_madd16<R>(reinterpret_cast<const i16*>(a), k, reinterpret_cast<const i16*>(x), k, interval, sum);
+        else if (has_avx2())
+            p = avx2::gemv_mul32<R>(reinterpret_cast<const i16*>(a), k, reinterpret_cast<const i16*>(x), k, sum);
+    }
+    else if constexpr(has_mul32<TA, TB> && sizeof(ba) >= sizeof(i16) && sizeof(bb) >= sizeof(i16)) {
+        if (has_avx2())
+            p = avx2::gemv_mul32<R>(reinterpret_cast<const ba*>(a), k, reinterpret_cast<const bb*>(x), k, sum);
+    }
+#endif
+    for (; p < k; p++)
+        for (std::size_t r = 0; r < R; r++)
+            sum[r] = wrapping_add(sum[r], static_cast<W>(W(a[r * k + p].raw()) * W(x[p].raw())));
+
+    for (std::size_t r = 0; r < R; r++)
+        y[r] = from_wide<TY, from>(sum[r]);
+}
+
+// The rows of a are bounded by their type rather than scanned, which would
+// read a a second time.
+template<fixed_point TA, fixed_point TB, fixed_point TY>
+void gemv_rows(const TA* a, const TB* x, TY* y, std::size_t m, std::size_t k) {
+    std::size_t interval = 0;
+    if constexpr(has_madd16<TA, TB>)
+        interval = madd16_interval(u32(1) << 15, max_abs(x, k));
+
+    std::size_t i = 0;
+    for (; i + 4 <= m; i += 4)
+        gemv_block<4>(a + i * k, x, y + i, k, interval);
+    for (; i < m; i++)
+        gemv_block<1>(a + i * k, x, y + i, k, interval);
+}
+
+// Calls body(row, rows) over [0, m), split into up to `threads` ranges of
+// at least 16 rows, the last one on the calling thread.
+template<typename F>
+void split_rows(std::size_t m, unsigned threads, F body) {
+    const std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(threads, (m + 15) / 16));
+    if (parts == 1)
+        return body(std::size_t(0), m);
+
+    const std::size_t chunk = (m + parts - 1) / parts;
+    std::vector<std::thread> pool;
+    std::size_t row = 0;
+    for (; row + chunk < m; row += chunk)
+        pool.emplace_back(body, row, chunk);
+    body(row, m - row);
+    for (auto& t : pool)
+        t.join();
+}
+
+}
+
+// c = a * b, for a (m x k), b (k x n) and c (m x n), with c's policies.
+// c must not overlap the inputs.
+template<fixed_point TA, fixed_point TB, fixed_point TC>
+void gemm(std::span<const TA> a, std::span<const TB> b, std::span<TC> c,
+          std::size_t m, std::size_t n, std::size_t k, unsigned threads = 1) {
+    static_assert(TA::is_signed == TB::is_signed, "Products of mixed signedness are not supported!");
+
+    if (k == 0) {
+        std::fill_n(c.data(), m * n, TC::from_raw(0));
+        return;
+    }
+    impl::split_rows(m, threads, [&](std::size_t row, std::size_t rows) {
+        impl::gemm_rows(a.data() + row * k, b.data(), c.data() + row * n, rows, n, k);
+    });
+}
+
+// y = a * x, for a (m x k), x (k) and y (m), with y's policies.
+template<fixed_point TA, fixed_point TB, fixed_point TY>
+void gemv(std::span<const TA> a, std::span<const TB> x, std::span<TY> y,
+          std::size_t m, std::size_t k, unsigned threads = 1) {
+    static_assert(TA::is_signed == TB::is_signed, "Products of mixed signedness are not supported!");
+
+    impl::split_rows(m, threads, [&](std::size_t row, std::size_t rows) {
+        impl::gemv_rows(a.data() + row * k, x.data(), y.data() + row, rows, k);
+    });
+}
+
+}
@@ -1,21 +1,32 @@
 #pragma once
 
 #include "./math.hpp"
+#include "./charconv.hpp"
 
-#include <bit>
 #include <iostream>
+#include <string>
+#include <string_view>
 
 namespace fxd {
 
-template<std::integral base, int fp>
-std::ostream& operator<<(std::ostream& o, const fixed<base, fp> value) {
-    o << static_cast<base>(value);
+// Shortest round trip, or precision() fraction digits under std::fixed.
+// Width and fill apply to the whole number, as for built-in types.
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+std::ostream& operator<<(std::ostream& o, const fixed<base, fp, ovf, rnd> value) {
+    const bool fixed_digits = (o.flags() & std::ios::floatfield) == std::ios::fixed;
+    const int precision = fixed_digits ? static_cast<int>(o.precision()) : -1;
 
-    base frac = value.frac().raw();
-    int zero_fill = std::countl_zero(frac) - fp;
-    for (; zero_fill >= 0; zero_fill--) o << '0';
-
-    o << static_cast<base>(value.frac() * 10000);
+    char buffer[128];
+    const auto result = to_chars(buffer, buffer + sizeof(buffer), value, precision);
+    if (result.ec == std::errc()) {
+        o << std::string_view(buffer, result.ptr);
+    }
+    else {
+        std::string text(static_cast<std::size_t>(precision) + sizeof(buffer), '\0');
+        text.resize(static_cast<std::size_t>(to_chars(text.data(), text.data() + text.size(), value, precision).ptr - text.data()));
+        o << text;
+    }
+    return o;
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./math.hpp"
+#include "./accumulator.hpp"
+
+// Vectors, matrices and quaternions over any fixed type.
+// Sums of products (dot, cross, mat * vec, mat * mat, quaternion products)
+// are accumulated unshifted in next_type and shifted once per output,
+// so they cost one shift and one rounding instead of one per term.
+
+namespace fxd {
+
+namespace impl {
+
+// math.hpp works on the wrapping types, so call it through them.
+template<fixed_point T>
+constexpr T sqrt(T s) {
+    return fxd::sqrt<typename T::base_type, T::frac_bits>(s);
+}
+
+template<fixed_point T>
+constexpr T rsqrt(T s) {
+    return fxd::rsqrt<typename T::base_type, T::frac_bits>(s);
+}
+
+}
+
+// Vectors
+
+template<fixed_point T>
+struct vec2 {
+    T x, y;
+
+    constexpr friend vec2 operator+(vec2 a, vec2 b) { return { a.x + b.x, a.y + b.y }; }
+    constexpr friend vec2 operator-(vec2 a, vec2 b) { return { a.x - b.x, a.y - b.y }; }
+    constexpr friend vec2 operator*(vec2 a, T s)    { return { a.x * s, a.y * s }; }
+    constexpr friend vec2 operator*(T s, vec2 a)    { return a * s; }
+    constexpr friend vec2 operator/(vec2 a, T s)    { return { a.x / s, a.y / s }; }
+    constexpr vec2 operator-() const                { return { -x, -y }; }
+
+    constexpr vec2& operator+=(vec2 other) { return *this = *this + other; }
+    constexpr vec2& operator-=(vec2 other) { return *this = *this - other; }
+    constexpr vec2& operator*=(T s)        { return *this = *this * s; }
+
+    constexpr friend bool operator==(vec2 a, vec2 b) = default;
+};
+
+template<fixed_point T>
+struct vec3 {
+    T x, y, z;
+
+    constexpr friend vec3 operator+(vec3 a, vec3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    constexpr friend vec3 operator-(vec3 a, vec3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    constexpr friend vec3 operator*(vec3 a, T s)    { return { a.x * s, a.y * s, a.z * s }; }
+    constexpr friend vec3 operator*(T s, vec3 a)    { return a * s; }
+    constexpr friend vec3 operator/(vec3 a, T s)    { return { a.x / s, a.y / s, a.z / s }; }
+    constexpr vec3 operator-() const                { return { -x, -y, -z }; }
+
+    constexpr vec3& operator+=(vec3 other) { return *this = *this + other; }
+    constexpr vec3& operator-=(vec3 other) { return *this = *this - other; }
+    constexpr vec3& operator*=(T s)        { return *this = *this * s; }
+
+    constexpr friend bool operator==(vec3 a, vec3 b) = default;
+};
+
+template<fixed_point T>
+struct vec4 {
+    T x, y, z, w;
+
+    constexpr friend vec4 operator+(vec4 a, vec4 b) { return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; }
+    constexpr friend vec4 operator-(vec4 a, vec4 b) { return { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; }
+    constexpr friend vec4 operator*(vec4 a, T s)    { return { a.x * s, a.y * s, a.z * s, a.w * s }; }
+    constexpr friend vec4 operator*(T s, vec4 a)    { return a * s; }
+    constexpr friend vec4 operator/(vec4 a, T s)    { return { a.x / s, a.y / s, a.z / s, a.w / s }; }
+    constexpr vec4 operator-() const                { return { -x, -y, -z, -w }; }
+
+    constexpr vec4& operator+=(vec4 other) { return *this = *this + other; }
+    constexpr vec4& operator-=(vec4 other) { return *this = *this - other; }
+    constexpr vec4& operator*=(T s)        { return *this = *this * s; }
+
+    constexpr friend bool operator==(vec4 a, vec4 b) = default;
+};
+
+template<fixed_point T>
+constexpr T dot(vec2<T> a, vec2<T> b) {
+    using impl::wide_mul;
+    return T::from_product(wide_mul(a.x, b.x) + wide_mul(a.y, b.y));
+}
+
+template<fixed_point T>
+constexpr T dot(vec3<T> a, vec3<T> b) {
+    using impl::wide_mul;
+    return T::from_product(wide_mul(a.x, b.x) + wide_mul(a.y, b.y) + wide_mul(a.z, b.z));
+}
+
+template<fixed_point T>
+constexpr T dot(vec4<T> a, vec4<T> b) {
+    using impl::wide_mul;
+    return T::from_product(wide_mul(a.x, b.x) + wide_mul(a.y, b.y) + wide_mul(a.z, b.z) + wide_mul(a.w, b.w));
+}
+
+// z component of the 3D cross product.
+template<fixed_point T>
+constexpr T cross(vec2<T> a, vec2<T> b) {
+    using impl::wide_mul;
+    return T::from_product(wide_mul(a.x, b.y) - wide_mul(a.y, b.x));
+}
+
+template<fixed_point T>
+constexpr vec3<T> cross(vec3<T> a, vec3<T> b) {
+    using impl::wide_mul;
+    return {
+        T::from_product(wide_mul(a.y, b.z) - wide_mul(a.z, b.y)),
+        T::from_product(wide_mul(a.z, b.x) - wide_mul(a.x, b.z)),
+        T::from_product(wide_mul(a.x, b.y) - wide_mul(a.y, b.x))
+    };
+}
+
+template<typename V>
+constexpr auto length_sq(V v) {
+    return dot(v, v);
+}
+
+template<typename V>
+constexpr auto length(V v) {
+    return impl::sqrt(dot(v, v));
+}
+
+template<typename V>
+constexpr V normalize(V v) {
+    return v * impl::rsqrt(dot(v, v));
+}
+
+// Matrices, row-major.
+
+template<fixed_point T>
+struct mat3 {
+    T m[3][3];
+
+    static constexpr mat3 identity() {
+        return {{ { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } }};
+    }
+
+    constexpr mat3 transpose() const {
+        mat3 out;
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                out.m[i][j] = m[j][i];
+        return out;
+    }
+
+    constexpr friend vec3<T> operator*(const mat3& a, vec3<T> v) {
+        using impl::wide_mul;
+        auto row = [&] (int i) {
+            return T::from_product(wide_mul(a.m[i][0], v.x) + wide_mul(a.m[i][1], v.y) + wide_mul(a.m[i][2], v.z));
+        };
+        return { row(0), row(1), row(2) };
+    }
+
+    constexpr friend mat3 operator*(const mat3& a, const mat3& b) {
+        mat3 out;
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++) {
+                impl::wide_t<T> sum = 0;
+                for (int k = 0; k < 3; k++)
+                    sum += impl::wide_mul(a.m[i][k], b.m[k][j]);
+                out.m[i][j] = T::from_product(sum);
+            }
+        return out;
+    }
+
+    constexpr friend bool operator==(const mat3& a, const mat3& b) = default;
+};
+
+template<fixed_point T>
+struct mat4 {
+    T m[4][4];
+
+    static constexpr mat4 identity() {
+        return {{ { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } }};
+    }
+
+    constexpr mat4 transpose() const {
+        mat4 out;
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                out.m[i][j] = m[j][i];
+        return out;
+    }
+
+    constexpr friend vec4<T> operator*(const mat4& a, vec4<T> v) {
+        using impl::wide_mul;
+        auto row = [&] (int i) {
+            return T::from_product(wide_mul(a.m[i][0], v.x) + wide_mul(a.m[i][1], v.y) +
+                                   wide_mul(a.m[i][2], v.z) + wide_mul(a.m[i][3], v.w));
+        };
+        return { row(0), row(1), row(2), row(3) };
+    }
+
+    constexpr friend mat4 operator*(const mat4& a, const mat4& b) {
+        mat4 out;
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++) {
+                impl::wide_t<T> sum = 0;
+                for (int k = 0; k < 4; k++)
+                    sum += impl::wide_mul(a.m[i][k], b.m[k][j]);
+                out.m[i][j] = T::from_product(sum);
+            }
+        return out;
+    }
+
+    constexpr friend bool operator==(const mat4& a, const mat4& b) = default;
+};
+
+// Transforms a point, with an implicit w of 1. The projective row is ignored.
+template<fixed_point T>
+constexpr vec3<T> transform_point(const mat4<T>& a, vec3<T> p) {
+    using impl::wide_mul;
+    auto row = [&] (int i) {
+        return T::from_product(wide_mul(a.m[i][0], p.x) + wide_mul(a.m[i][1], p.y) +
+                               wide_mul(a.m[i][2], p.z) + impl::widen(a.m[i][3]));
+    };
+    return { row(0), row(1), row(2) };
+}
+
+// Transforms a direction, with an implicit w of 0.
+template<fixed_point T>
+constexpr vec3<T> transform_dir(const mat4<T>& a, vec3<T> d) {
+    using impl::wide_mul;
+    auto row = [&] (int i) {
+        return T::from_product(wide_mul(a.m[i][0], d.x) + wide_mul(a.m[i][1], d.y) + wide_mul(a.m[i][2], d.z));
+    };
+    return { row(0), row(1), row(2) };
+}
+
+// Quaternions
+
+template<fixed_point T>
+struct quat {
+    T w, x, y, z;
+
+    static constexpr quat identity() {
+        return { 1, 0, 0, 0 };
+    }
+
+    // axis must be normalized. Sign conventions follow sincos.
+    static constexpr quat from_axis_angle(vec3<T> axis, T angle) {
+        trig_t s, c;
+        sincos<typename T::base_type, T::frac_bits>(angle >> 1, s, c);
+        const T ts = s;
+        return { T(c), axis.x * ts, axis.y * ts, axis.z * ts };
+    }
+
+    constexpr quat conjugate() const {
+        return { w, -x, -y, -z };
+    }
+
+    constexpr friend quat operator*(quat a, quat b) {
+        using impl::wide_mul;
+        return {
+            T::from_product(wide_mul(a.w, b.w) - wide_mul(a.x, b.x) - wide_mul(a.y, b.y) - wide_mul(a.z, b.z)),
+            T::from_product(wide_mul(a.w, b.x) + wide_mul(a.x, b.w) + wide_mul(a.y, b.z) - wide_mul(a.z, b.y)),
+            T::from_product(wide_mul(a.w, b.y) - wide_mul(a.x, b.z) + wide_mul(a.y, b.w) + wide_mul(a.z, b.x)),
+            T::from_product(wide_mul(a.w, b.z) + wide_mul(a.x, b.y) - wide_mul(a.y, b.x) + wide_mul(a.z, b.w))
+        };
+    }
+
+    constexpr friend bool operator==(quat a, quat b) = default;
+};
+
+template<fixed_point T>
+constexpr T dot(quat<T> a, quat<T> b) {
+    using impl::wide_mul;
+    return T::from_product(wide_mul(a.w, b.w) + wide_mul(a.x, b.x) + wide_mul(a.y, b.y) + wide_mul(a.z, b.z));
+}
+
+template<fixed_point T>
+constexpr quat<T> normalize(quat<T> q) {
+    const T s = impl::rsqrt(dot(q, q));
+    return { q.w * s, q.x * s, q.y * s, q.z * s };
+}
+
+// Rotation matrix of a unit quaternion.
+template<fixed_point T>
+constexpr mat3<T> to_mat3(quat<T> q) {
+    using impl::wide_mul;
+    using impl::widen;
+
+    // Each entry is 1 - 2(a + b) or 2(a +- b), built from one wide sum.
+    auto diag = [] (impl::wide_t<T> sum) { return T::from_product(widen(T(1)) - (sum << 1)); };
+    auto off  = [] (impl::wide_t<T> sum) { return T::from_product(sum << 1); };
+
+    return {{
+        { diag(wide_mul(q.y, q.y) + wide_mul(q.z, q.z)), off(wide_mul(q.x, q.y) - wide_mul(q.w, q.z)), off(wide_mul(q.x, q.z) + wide_mul(q.w, q.y)) },
+        { off(wide_mul(q.x, q.y) + wide_mul(q.w, q.z)), diag(wide_mul(q.x, q.x) + wide_mul(q.z, q.z)), off(wide_mul(q.y, q.z) - wide_mul(q.w, q.x)) },
+        { off(wide_mul(q.x, q.z) - wide_mul(q.w, q.y)), off(wide_mul(q.y, q.z) + wide_mul(q.w, q.x)), diag(wide_mul(q.x, q.x) + wide_mul(q.y, q.y)) }
+    }};
+}
+
+// Rotates v by a unit quaternion, as to_mat3(q) * v. Each matrix entry and
+// each output component is one wide sum, shifted once, and the span rotate
+// takes the same path, so both give the same bits.
+template<fixed_point T>
+constexpr vec3<T> rotate(quat<T> q, vec3<T> v) {
+    return to_mat3(q) * v;
+}
+
+// Batch transforms. Outputs must be at least as long as the input.
+
+template<fixed_point T>
+void transform(const mat3<T>& m, std::span<const vec3<T>> in, std::span<vec3<T>> out) {
+    for (std::size_t i = 0; i < in.size(); i++)
+        out[i] = m * in[i];
+}
+
+template<fixed_point T>
+void transform_point(const mat4<T>& m, std::span<const vec3<T>> in, std::span<vec3<T>> out) {
+    for (std::size_t i = 0; i < in.size(); i++)
+        out[i] = transform_point(m, in[i]);
+}
+
+template<fixed_point T>
+void transform_dir(const mat4<T>& m, std::span<const vec3<T>> in, std::span<vec3<T>> out) {
+    for (std::size_t i = 0; i < in.size(); i++)
+        out[i] = transform_dir(m, in[i]);
+}
+
+// Builds the rotation matrix once, then nine products per point.
+template<fixed_point T>
+void rotate(quat<T> q, std::span<const vec3<T>> in, std::span<vec3<T>> out) {
+    transform(to_mat3(q), in, out);
+}
+
+}
@@ -1,181 +1,798 @@
+// Benchmark suite: every math function on every fixed format, against the
+// float and double libm call it replaces.
+//
+//   g++ -std=c++20 -O2 -pthread main.cpp -o bench
+//   ./bench [--csv | --json] [--filter=<text>] [--min-time=<ms>]
+//
+// Latency chains each call's input on the previous result through the
+// index of a load, so every type pays the same extra load. Throughput runs
+// independent calls over a 4096-element array. Both are in ns per call,
+// the best of five runs. Speedups are libm throughput over fixed throughput.
+//
+// Conversion rows time the span against a scalar loop converting each
+// element, shown in both reference columns, and add GB/s over the bytes
+// the span reads and writes. to_chars[span] and from_chars[span] instead
+// compare with std::to_chars and std::from_chars on float and double, and
+// their bytes include the text.
+//
+// Rows named op[vs ...] on 64-bit formats instead time another way to get
+// the same fixed result, shown in both reference columns: a double
+// round-trip, long multiplication from 32-bit halves, generic 128-bit
+// division or fmod. The double round-trip keeps only 53 bits, so it is a
+// speed bound rather than an equal result.
+//
+// sin[wide] and cos[wide] reduce inputs up to +-100 without a divide.
+// The [wide %tau] rows first run the s %= tau that sin and cos used before,
+// which shows what the modulo costs on top.
+//
+// gemm rows multiply 64 x k by k x 64 and gemv rows 4096 x k by k, so both
+// time 4096 outputs, against plain loops over float and double arrays.
+// GOP/s counts a multiply and an add per term.
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
 #include <cmath>
-#include <format>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "fixed.hpp"
 #include "math.hpp"
+#include "batch.hpp"
+#include "fast.hpp"
+#include "native.hpp"
+#include "angle.hpp"
+#include "cordic.hpp"
+#include "convert.hpp"
+#include "charconv.hpp"
+#include "piecewise.hpp"
+#include "gemm.hpp"
+
+namespace {
+
+constexpr std::size_t count = 4096;
+
+struct options {
+    enum { table, csv, json } output = table;
+    std::string filter;
+    double min_time_ms = 1.0;
+};
+
+struct timing {
+    double latency = 0;
+    double throughput = 0;
+};
+
+struct result {
+    std::string function;
+    std::string format;
+    timing fixed, single, dual;
+    double bytes = 0; // Per element, for conversions
+    double ops = 0;   // Per element, for matrix products
+};
+
+struct domain {
+    double lo, hi;
+};
+
+volatile std::uint64_t zero_mask = 0;
+volatile std::uint64_t sink = 0;
+
+template<typename T>
+std::uint64_t bits(T v) {
+    if constexpr(std::is_same_v<T, float>)
+        return std::bit_cast<std::uint32_t>(v);
+    else if constexpr(std::is_same_v<T, double>)
+        return std::bit_cast<std::uint64_t>(v);
+    else
+        return static_cast<std::uint64_t>(v.raw());
+}
+
+// Best of five runs of body(), in ns per element. The repeat count grows
+// until one run takes at least min_time_ms.
+template<typename F>
+double measure(const options& opt, F&& body) {
+    using clock = std::chrono::steady_clock;
+    body();
+
+    std::size_t reps = 1;
+    double best = 0;
+    for (;;) {
+        const auto start = clock::now();
+        for (std::size_t r = 0; r < reps; r++)
+            body();
+        const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        if (ms >= opt.min_time_ms || reps >= (1u << 20)) {
+            best = ms;
+            break;
+        }
+        reps *= 2;
+    }
+
+    for (int run = 0; run < 4; run++) {
+        const auto start = clock::now();
+        for (std::size_t r = 0; r < reps; r++)
+            body();
+        best = std::min(best, std::chrono::duration<double, std::milli>(clock::now() - start).count());
+    }
+    return best * 1e6 / (double(reps) * count);
+}
+
+template<typename T>
+std::vector<T> inputs(domain d, unsigned seed, std::size_t n = count) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(d.lo, d.hi);
+    std::vector<T> out(n);
+    for (auto& v : out)
+        v = T(dist(rng));
+    return out;
+}
+
+// The domain, clipped to what T can hold.
+template<typename T>
+domain clip(domain d) {
+    const double lo = double(T::min()) * 0.9;
+    const double hi = double(T::max()) * 0.9;
+    return { std::max(d.lo, lo), std::min(d.hi, hi) };
+}
+
+template<typename In, typename F>
+timing time_calls(const options& opt, const std::vector<In>& a, const std::vector<In>& b, F f) {
+    using Out = decltype(f(a[0], b[0]));
+    std::vector<Out> out(count);
+
+    timing t;
+    t.throughput = measure(opt, [&] {
+        for (std::size_t i = 0; i < count; i++)
+            out[i] = f(a[i], b[i]);
+        sink = sink + bits(out[count - 1]);
+    });
+
+    const std::uint64_t mask = zero_mask;
+    t.latency = measure(opt, [&] {
+        std::uint64_t dep = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            const std::size_t j = (i + dep) & (count - 1);
+            dep = bits(f(a[j], b[j])) & mask;
+        }
+        sink = sink + dep;
+    });
+    return t;
+}
+
+// The raw product a * b >> shift from four 32-bit partial products, as
+// done without a 128-bit type.
+fxd::i64 long_mul_shift(fxd::i64 a, fxd::i64 b, int shift) {
+    const bool negative = (a < 0) != (b < 0);
+    const fxd::u64 ua = a < 0 ? -fxd::u64(a) : fxd::u64(a);
+    const fxd::u64 ub = b < 0 ? -fxd::u64(b) : fxd::u64(b);
+
+    const fxd::u64 ll = (ua & 0xffffffff) * (ub & 0xffffffff);
+    const fxd::u64 lh = (ua & 0xffffffff) * (ub >> 32);
+    const fxd::u64 hl = (ua >> 32) * (ub & 0xffffffff);
+    const fxd::u64 hh = (ua >> 32) * (ub >> 32);
+
+    const fxd::u64 mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    const fxd::u64 lo = (mid << 32) | (ll & 0xffffffff);
+    const fxd::u64 hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+    const fxd::u64 q = (lo >> shift) | (shift ? (hi << (64 - shift)) : 0);
+    return negative ? -fxd::i64(q) : fxd::i64(q);
+}
+
+struct bench {
+    const options& opt;
+    std::vector<result>& results;
+    std::string_view format;
+
+    bool wanted(std::string_view function) const {
+        if (opt.filter.empty())
+            return true;
+        return function.find(opt.filter) != std::string_view::npos ||
+               format.find(opt.filter) != std::string_view::npos;
+    }
+
+    // fixed_fn takes (T, T), ref_fn is a generic (x, y) called with float and double.
+    template<typename T, typename F, typename R>
+    void binary(std::string_view function, domain da, domain db, F fixed_fn, R ref_fn) {
+        if (!wanted(function))
+            return;
+
+        const auto a = inputs<T>(clip<T>(da), 1);
+        const auto b = inputs<T>(clip<T>(db), 2);
+
+        std::vector<float> af(count), bf(count);
+        std::vector<double> ad(count), bd(count);
+        for (std::size_t i = 0; i < count; i++) {
+            af[i] = float(a[i]); bf[i] = float(b[i]);
+            ad[i] = double(a[i]); bd[i] = double(b[i]);
+        }
+
+        results.push_back({
+            std::string(function), std::string(format),
+            time_calls(opt, a, b, fixed_fn),
+            time_calls(opt, af, bf, ref_fn),
+            time_calls(opt, ad, bd, ref_fn)
+        });
+    }
+
+    template<typename T, typename F, typename R>
+    void unary(std::string_view function, domain d, F fixed_fn, R ref_fn) {
+        binary<T>(function, d, d,
+            [=](T x, T) { return fixed_fn(x); },
+            [=](auto x, auto) { return ref_fn(x); });
+    }
+
+    // Span kernels have no dependent chain, so their latency column
+    // repeats the throughput. fixed_fn takes (a, b, out) spans.
+    template<typename T, typename Out = T, typename F, typename R>
+    void binary_span(std::string_view function, domain da, domain db, F fixed_fn, R ref_fn) {
+        if (!wanted(function))
+            return;
+
+        const auto a = inputs<T>(clip<T>(da), 1);
+        const auto b = inputs<T>(clip<T>(db), 2);
+        std::vector<float> af(count), bf(count);
+        std::vector<double> ad(count), bd(count);
+        for (std::size_t i = 0; i < count; i++) {
+            af[i] = float(a[i]); bf[i] = float(b[i]);
+            ad[i] = double(a[i]); bd[i] = double(b[i]);
+        }
+
+        std::vector<Out> out(count);
+        const double fixed_ns = measure(opt, [&] {
+            fixed_fn(std::span<const T>(a), std::span<const T>(b), std::span<Out>(out));
+            sink = sink + bits(out[count - 1]);
+        });
+
+        auto reference = [&](const auto& in_a, const auto& in_b) {
+            std::vector<std::remove_cvref_t<decltype(in_a[0])>> ref_out(count);
+            const double ns = measure(opt, [&] {
+                for (std::size_t i = 0; i < count; i++)
+                    ref_out[i] = ref_fn(in_a[i], in_b[i]);
+                sink = sink + bits(ref_out[count - 1]);
+            });
+            return timing{ ns, ns };
+        };
+
+        results.push_back({
+            std::string(function), std::string(format),
+            timing{ fixed_ns, fixed_ns }, reference(af, bf), reference(ad, bd)
+        });
+    }
+
+    // span_fn converts a span of In to Out, scalar_fn one element.
+    template<typename In, typename Out, typename F, typename S>
+    void conversion(std::string_view function, const std::vector<In>& in, F span_fn, S scalar_fn) {
+        if (!wanted(function))
+            return;
+
+        std::vector<Out> out(count);
+        const double span_ns = measure(opt, [&] {
+            span_fn(std::span<const In>(in), std::span<Out>(out));
+            sink = sink + bits(out[count - 1]);
+        });
+        const double scalar_ns = measure(opt, [&] {
+            for (std::size_t i = 0; i < count; i++)
+                out[i] = scalar_fn(in[i]);
+            sink = sink + bits(out[count - 1]);
+        });
+
+        const timing scalar{ scalar_ns, scalar_ns };
+        results.push_back({
+            std::string(function), std::string(format),
+            timing{ span_ns, span_ns }, scalar, scalar, double(sizeof(In) + sizeof(Out))
+        });
+    }
+
+    // Writes in as comma-separated text, against std::to_chars on each
+    // value converted to float and double. All three are shortest round trip.
+    template<typename T>
+    void text(std::string_view function, const std::vector<T>& in) {
+        if (!wanted(function))
+            return;
+
+        std::vector<char> buffer(count * 64);
+        char* const first = buffer.data();
+        char* const last = first + buffer.size();
+
+        std::size_t written = 0;
+        const double fixed_ns = measure(opt, [&] {
+            written = std::size_t(fxd::to_chars(first, last, std::span<const T>(in), ',').ptr - first);
+            sink = sink + std::uint64_t(buffer[written - 1]);
+        });
+        auto reference = [&](auto cast) {
+            const double ns = measure(opt, [&] {
+                char* p = first;
+                for (std::size_t i = 0; i < count; i++) {
+                    p = std::to_chars(p, last, cast(in[i])).ptr;
+                    *p++ = ',';
+                }
+                sink = sink + std::uint64_t(p[-2]);
+            });
+            return timing{ ns, ns };
+        };
+
+        results.push_back({
+            std::string(function), std::string(format), timing{ fixed_ns, fixed_ns },
+            reference([](T v) { return float(v); }), reference([](T v) { return double(v); }),
+            double(sizeof(T)) + double(written) / count
+        });
+    }
+
+    // Reads the text of in back, against std::from_chars to float and double.
+    template<typename T>
+    void parse(std::string_view function, const std::vector<T>& in) {
+        if (!wanted(function))
+            return;
+
+        std::vector<char> buffer(count * 64);
+        const char* const first = buffer.data();
+        const char* const last = fxd::to_chars(buffer.data(), buffer.data() + buffer.size(), std::span<const T>(in), ',').ptr;
+
+        std::vector<T> out(count);
+        const double fixed_ns = measure(opt, [&] {
+            fxd::from_chars(first, last, std::span<T>(out));
+            sink = sink + bits(out[count - 1]);
+        });
+        auto reference = [&](auto v) {
+            const double ns = measure(opt, [&] {
+                const char* p = first;
+                for (std::size_t i = 0; i < count; i++)
+                    p = std::from_chars(p, last, v).ptr + 1;
+                sink = sink + bits(v);
+            });
+            return timing{ ns, ns };
+        };
+
+        results.push_back({
+            std::string(function), std::string(format), timing{ fixed_ns, fixed_ns },
+            reference(0.0f), reference(0.0), double(sizeof(T)) + double(last - first) / count
+        });
+    }
+
+    // fixed_fn against alt_fn, another way to the same T result, both
+    // taking (T, T). The alternative fills both reference columns.
+    template<typename T, typename F, typename A>
+    void versus(std::string_view function, domain da, domain db, F fixed_fn, A alt_fn) {
+        if (!wanted(function))
+            return;
+
+        const auto a = inputs<T>(clip<T>(da), 1);
+        const auto b = inputs<T>(clip<T>(db), 2);
+        const timing alt = time_calls(opt, a, b, alt_fn);
+        results.push_back({ std::string(function), std::string(format), time_calls(opt, a, b, fixed_fn), alt, alt });
+    }
+
+    // a (count / n x k) times b (k x n) into TC, through gemv when n is 1,
+    // against plain loops over float and double: a dot product per row for
+    // gemv, and i, k, j order for gemm.
+    template<typename TA, typename TB = TA, typename TC = TB>
+    void product(std::string_view function, domain d, std::size_t n, std::size_t k) {
+        if (!wanted(function))
+            return;
 
-int main() {
-    using real = double;
-
-    [[maybe_unused]] real start = 0;
-    [[maybe_unused]] real end = 2048.0;
-    [[maybe_unused]] real max_error = -999;
-    [[maybe_unused]] real total_error = 0;
-    [[maybe_unused]] real count = 0;
-
-    std::cout << std::fixed << std::setprecision(15);
-
-    fxd::fixed20 f = 1536.25724;
-    std::cout << int(f) << '.' << int(f.frac() * 1000) << '\n';
-
-    /*for (real i = -end; i < end; i += M_PI/32) {
-        fxd::trig_t s, c;
-        fxd::sincos(fxd::trig_t(i), s, c);
-
-        real ds, dc;
-        sincos(i, &ds, &dc);
-
-        if (std::abs(ds) <= 1e-05 || std::abs(dc) <= 1e-05)
-            continue;
-
-        auto outs = std::format("sin i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, (double)s, ds, 100.0 * std::abs(((double)s - ds)/ds));
-        auto outc = std::format("cos i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, (double)c, dc, 100.0 * std::abs(((double)c - dc)/dc));
-        std::cout << outc << outs;
-    }*/
-
-    /*for (real i = start; i < end; i += M_PI/32) {
-        fxd::trig_t s, c;
-        fxd::sincos(fxd::fixed20(i), s, c);
-        std::cout << double(s * s + c * c) << '\n';
-    }*/
-
-    for (real i = 1; i < 2.0; i += 0.001) {
-        if (i == 1) continue;
-        real result = (real)fxd::log2<int, 28>(i);
-        real expect = std::log2(i);
-        real rerror = (result - expect) / expect;
-        auto out = std::format("i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, result, expect, 100.0 * rerror);
-        std::cout << out;
-        if (std::abs(rerror) > max_error)
-            max_error = std::abs(rerror);
-        if (!std::isnan(rerror)) total_error += rerror;
-        count++;
-    }
-    std::cout << max_error * 100 << "% max rerror\n" << (total_error / count) * 100 << "% average\n";
-
-    /*for (double i = 0; i < 1.0; i += 0.0000001) {
-        real result = (real)fxd::asin(fxd::trig_t(i));
-        real expect = std::asin(i);
-        real rerror = (result - expect) / expect;
-        if (std::abs(rerror) > max_error)
-            max_error = std::abs(rerror);
-        if (!std::isnan(rerror)) total_error += rerror;
-        count++;
-    }
-    std::cout << max_error * 100 << "% max rerror\n" << (total_error / count) * 100 << "% average\n";*/
-
-    /*for (real i = start; i < end; i += 12.168743971) {
-        real result = (real)fxd::cbrt<int, 20>(i);
-        real expect = std::cbrt(i);
-        real rerror = (result - expect) / expect;
-        auto out = std::format("i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, result, expect, 100.0 * rerror);
-        std::cout << out;
-
-        if (std::abs(rerror) > max_error)
-            max_error = std::abs(rerror);
-        total_error += rerror; count++;
-    }
-    std::cout << max_error * 100 << "% max rerror\n" << (total_error / count) * 100 << "% average\n";*/
-
-    /*for (real i = start; i < end; i += 2.78178671) {
-        real result = (real)fxd::tan<int, 20>(i);
-        real expect = std::tan(i);
-        real rerror = (result - expect) / expect;
-        auto out = std::format("i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, result, expect, 100.0 * rerror);
-        std::cout << out;
-
-        if (std::abs(rerror) > max_error)
-            max_error = std::abs(rerror);
-    }
-    std::cout << max_error * 100 << "% max rerror\n";*/
-
-    /*for (real i = 0.0; i < 6.28; i += pi / 128) {
-        real d_sin = std::sin(i);
-        real d_cos = std::cos(i);
-        real d_atan2 = std::atan2(d_sin, d_cos);
-
-        fxd::trig_t v = i;
-        fxd::fixed24 f_sin = fxd::sin(v);
-        fxd::fixed24 f_cos = fxd::cos(v);
-        fxd::trig_t f_atan2 = fxd::atan2(f_sin, f_cos);
-
-        real result = real(f_atan2);
-        real expect = d_atan2;
-
-        real rerror = (result - expect) / expect;
-
-        auto out = std::format("y: {: .10f}, x: {: .10f} - ", real(f_sin), real(f_cos));
-        std::cout << out;
-
-        out = std::format("i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, result, expect, 100.0 * rerror);
-        std::cout << out;
-
-        if (std::abs(rerror) > max_error)
-            max_error = std::abs(rerror);
-        if (!std::isnan(rerror)) total_error += rerror; count++;
-    }
-    std::cout << max_error * 100 << "% max rerror\n" << (total_error / count) * 100 << "% average\n";*/
-
-    /*for (real i = start; i < end;) {
-        real result = (real)fxd::atan<int, 20>(i);
-        real expect = std::atan(i);
-        real rerror = (result - expect) / expect;
-        auto out = std::format("i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, result, expect, 100.0 * rerror);
-        std::cout << out;
-
-        if (std::abs(rerror) > max_error)
-            max_error = std::abs(rerror);
-
-        if (i < 1)
-            i += 1.0 / (1 << 7);
+        const std::size_t m = count / n;
+        const auto a = inputs<TA>(clip<TA>(d), 1, m * k);
+        const auto b = inputs<TB>(clip<TB>(d), 2, k * n);
+
+        std::vector<TC> c(count);
+        const double fixed_ns = measure(opt, [&] {
+            if (n == 1)
+                fxd::gemv(std::span<const TA>(a), std::span<const TB>(b), std::span<TC>(c), m, k);
+            else
+                fxd::gemm(std::span<const TA>(a), std::span<const TB>(b), std::span<TC>(c), m, n, k);
+            sink = sink + bits(c[count - 1]);
+        });
+
+        auto reference = [&](auto zero) {
+            using F = decltype(zero);
+            const std::vector<F> af(a.begin(), a.end());
+            const std::vector<F> bf(b.begin(), b.end());
+            std::vector<F> cf(count);
+            const double ns = measure(opt, [&] {
+                if (n == 1) {
+                    for (std::size_t i = 0; i < m; i++) {
+                        F sum = zero;
+                        for (std::size_t p = 0; p < k; p++)
+                            sum += af[i * k + p] * bf[p];
+                        cf[i] = sum;
+                    }
+                }
+                else {
+                    std::fill(cf.begin(), cf.end(), zero);
+                    for (std::size_t i = 0; i < m; i++)
+                        for (std::size_t p = 0; p < k; p++) {
+                            const F s = af[i * k + p];
+                            for (std::size_t j = 0; j < n; j++)
+                                cf[i * n + j] += s * bf[p * n + j];
+                        }
+                }
+                sink = sink + bits(cf[count - 1]);
+            });
+            return timing{ ns, ns };
+        };
+
+        result r{
+            std::string(function), std::string(format),
+            timing{ fixed_ns, fixed_ns }, reference(0.0f), reference(0.0)
+        };
+        r.ops = 2.0 * double(k);
+        results.push_back(r);
+    }
+
+    template<typename T, typename Out = T, typename F, typename R>
+    void span(std::string_view function, domain d, F fixed_fn, R ref_fn) {
+        binary_span<T, Out>(function, d, d,
+            [=](std::span<const T> a, std::span<const T>, std::span<Out> out) { fixed_fn(a, out); },
+            [=](auto x, auto) { return ref_fn(x); });
+    }
+};
+
+// Curves for the fitted tables.
+struct tanh_curve {
+    static constexpr double lo = -8, hi = 8;
+    constexpr double operator()(double x) const { return std::tanh(x); }
+};
+
+struct sigmoid_curve {
+    static constexpr double lo = -16, hi = 16;
+    constexpr double operator()(double x) const { return 1 / (1 + std::exp(-x)); }
+};
+
+template<typename T>
+void run_format(const options& opt, std::vector<result>& results, std::string_view format) {
+    bench b{ opt, results, format };
+    using fxd::exp_t;
+    using fxd::trig_t;
+    using ct = std::span<const T>;
+
+    constexpr double tau = 6.283185307179586;
+    const domain any      = { -100.0, 100.0 };
+    const domain positive = { 0.01, 1000.0 };
+
+    // Arithmetic
+    b.binary<T>("mul", any, any, [](T x, T y) { return x * y; }, [](auto x, auto y) { return x * y; });
+    b.binary<T>("div", any, { 0.5, 100.0 }, [](T x, T y) { return x / y; }, [](auto x, auto y) { return x / y; });
+    b.binary<T>("mod", positive, { 0.5, 100.0 }, [](T x, T y) { return x % y; }, [](auto x, auto y) { return std::fmod(x, y); });
+
+    // 128-bit intermediates against the ways around them
+    if constexpr(sizeof(typename T::base_type) == sizeof(fxd::i64) && T::is_signed) {
+        using base = typename T::base_type;
+        constexpr int fp = T::frac_bits;
+        const domain wide = { -40000, 40000 }, divisor = { 0.5, 40 };
+
+        b.versus<T>("mul[vs double]", wide, divisor,
+            [](T x, T y) { return x * y; }, [](T x, T y) { return T(double(x) * double(y)); });
+        b.versus<T>("mul[vs long mul]", wide, divisor,
+            [](T x, T y) { return x * y; }, [](T x, T y) { return T::from_raw(long_mul_shift(x.raw(), y.raw(), fp)); });
+        b.versus<T>("div[vs double]", wide, divisor,
+            [](T x, T y) { return x / y; }, [](T x, T y) { return T(double(x) / double(y)); });
+        b.versus<T>("div[vs i128 div]", wide, divisor,
+            [](T x, T y) { return x / y; },
+            [](T x, T y) { return T::from_raw(base((fxd::i128(x.raw()) << fp) / fxd::i128(y.raw()))); });
+        b.versus<T>("mod[vs fmod]", wide, divisor,
+            [](T x, T y) { return x % y; }, [](T x, T y) { return T(std::fmod(double(x), double(y))); });
+    }
+
+    // Exponents
+    b.unary<T>("sqrt",  positive,      [](T x) { return fxd::sqrt(x); },  [](auto x) { return std::sqrt(x); });
+    b.unary<T>("rsqrt", positive,      [](T x) { return fxd::rsqrt(x); }, [](auto x) { return 1 / std::sqrt(x); });
+    b.unary<T>("rcp",   { 0.5, 1000 }, [](T x) { return fxd::rcp(x); },   [](auto x) { return 1 / x; });
+    b.unary<T>("cbrt",  positive,      [](T x) { return fxd::cbrt(x); },  [](auto x) { return std::cbrt(x); });
+    b.binary<T>("hypot", { 0, 10 }, { 0, 10 },
+        [](T x, T y) { return fxd::hypot(x, y); }, [](auto x, auto y) { return std::hypot(x, y); });
+
+    // Logarithms
+    b.unary<T>("log2",  positive, [](T x) { return fxd::log2(x); },  [](auto x) { return std::log2(x); });
+    b.unary<T>("log",   positive, [](T x) { return fxd::log(x); },   [](auto x) { return std::log(x); });
+    b.unary<T>("log10", positive, [](T x) { return fxd::log10(x); }, [](auto x) { return std::log10(x); });
+
+    // Powers
+    b.unary<T>("exp2",  { 0, 4 }, [](T x) { return fxd::exp2(x); },  [](auto x) { return std::exp2(x); });
+    b.unary<T>("exp",   { 0, 2 }, [](T x) { return fxd::exp(x); },   [](auto x) { return std::exp(x); });
+    b.unary<T>("exp10", { 0, 1 }, [](T x) { return fxd::exp10(x); }, [](auto x) { return std::pow(decltype(x)(10), x); });
+    b.binary<T>("pow", { 0.5, 4 }, { -2, 2 },
+        [](T x, T y) { return fxd::pow(x, exp_t(y)); }, [](auto x, auto y) { return std::pow(x, y); });
+
+    // Precision tiers at the format's own frac_bits, see fast.hpp
+    b.unary<T>("log2[fast]", positive, [](T x) { return fxd::fast::log2(x); }, [](auto x) { return std::log2(x); });
+    b.unary<T>("exp2[fast]", { 0, 4 },  [](T x) { return fxd::fast::exp2(x); }, [](auto x) { return std::exp2(x); });
+    b.unary<T>("exp[fast]",  { 0, 2 },  [](T x) { return fxd::fast::exp(x); },  [](auto x) { return std::exp(x); });
+
+    // In the caller's format, see native.hpp
+    b.unary<T>("log2[native]",  positive, [](T x) { return fxd::native::log2(x); },  [](auto x) { return std::log2(x); });
+    b.unary<T>("log[native]",   positive, [](T x) { return fxd::native::log(x); },   [](auto x) { return std::log(x); });
+    b.unary<T>("log10[native]", positive, [](T x) { return fxd::native::log10(x); }, [](auto x) { return std::log10(x); });
+
+    // Spans
+    if constexpr(sizeof(typename T::base_type) == sizeof(fxd::i32)) {
+        b.span<T>("sqrt[span]",  positive,      [](ct in, std::span<T> out) { fxd::sqrt(in, out); },  [](auto x) { return std::sqrt(x); });
+        b.span<T>("rsqrt[span]", positive,      [](ct in, std::span<T> out) { fxd::rsqrt(in, out); }, [](auto x) { return 1 / std::sqrt(x); });
+        b.span<T>("rcp[span]",   { 0.5, 1000 }, [](ct in, std::span<T> out) { fxd::rcp(in, out); },   [](auto x) { return 1 / x; });
+        b.span<T, exp_t>("log2[span]",  positive, [](ct in, std::span<exp_t> out) { fxd::log2(in, out); },  [](auto x) { return std::log2(x); });
+        b.span<T, exp_t>("log[span]",   positive, [](ct in, std::span<exp_t> out) { fxd::log(in, out); },   [](auto x) { return std::log(x); });
+        b.span<T>("exp2[span]",  { 0, 4 },   [](ct in, std::span<T> out) { fxd::exp2(in, out); },  [](auto x) { return std::exp2(x); });
+        b.span<T>("exp[span]",   { 0, 2 },   [](ct in, std::span<T> out) { fxd::exp(in, out); },   [](auto x) { return std::exp(x); });
+        b.span<T>("exp10[span]", { 0, 1 },   [](ct in, std::span<T> out) { fxd::exp10(in, out); }, [](auto x) { return std::pow(decltype(x)(10), x); });
+        b.span<T>("pow[span]",   { 0.5, 4 }, [](ct in, std::span<T> out) { fxd::pow(in, exp_t(1.5), out); },
+            [](auto x) { return std::pow(x, decltype(x)(1.5)); });
+    }
+
+    // Conversions, see convert.hpp
+    {
+        using base = typename T::base_type;
+        using rounded_t = fxd::fixed<base, T::frac_bits, fxd::overflow::saturate, fxd::rounding::half_even>;
+        using narrow_t = fxd::fixed<base, T::frac_bits - 4, fxd::overflow::saturate, fxd::rounding::half_even>;
+
+        const auto single = inputs<float>(clip<T>(any), 1);
+        const auto dual = inputs<double>(clip<T>(any), 1);
+        const auto x = inputs<T>(clip<T>(any), 1);
+        using cf = std::span<const float>;
+        using cd = std::span<const double>;
+
+        b.conversion<float, T>("from_float[span]", single,
+            [](cf in, std::span<T> out) { fxd::convert(in, out); }, [](float v) { return T(v); });
+        b.conversion<float, rounded_t>("from_float[sat span]", single,
+            [](cf in, std::span<rounded_t> out) { fxd::convert(in, out); }, [](float v) { return rounded_t(v); });
+        b.conversion<double, T>("from_double[span]", dual,
+            [](cd in, std::span<T> out) { fxd::convert(in, out); }, [](double v) { return T(v); });
+        b.conversion<T, float>("to_float[span]", x,
+            [](ct in, std::span<float> out) { fxd::convert(in, out); }, [](T v) { return float(v); });
+        b.conversion<T, double>("to_double[span]", x,
+            [](ct in, std::span<double> out) { fxd::convert(in, out); }, [](T v) { return double(v); });
+        b.conversion<T, narrow_t>("convert[span]", x,
+            [](ct in, std::span<narrow_t> out) { fxd::convert(in, out); }, [](T v) { return narrow_t(v); });
+        b.text<T>("to_chars[span]", x);
+        b.parse<T>("from_chars[span]", x);
+    }
+
+    // Matrix products, see gemm.hpp
+    b.product<T>("gemm", { -1, 1 }, 64, 256);
+    b.product<T>("gemv", { -1, 1 }, 1, 256);
+    if constexpr(std::is_same_v<T, fxd::fixed16>) {
+        b.product<fxd::hfixed12, T>("gemm[hfixed12 weights]", { -1, 1 }, 64, 256);
+        b.product<fxd::hfixed12, T>("gemv[hfixed12 weights]", { -1, 1 }, 1, 256);
+    }
+
+    // CORDIC against the polynomial paths, see cordic.hpp
+    if constexpr(sizeof(typename T::base_type) <= sizeof(fxd::i32)) {
+        b.binary<T>("hypot[cordic]", { 0, 10 }, { 0, 10 },
+            [](T x, T y) { return fxd::cordic::hypot(x, y); }, [](auto x, auto y) { return std::hypot(x, y); });
+        b.binary<T>("atan2[cordic]", any, any,
+            [](T y, T x) { return fxd::cordic::atan2(y, x); }, [](auto y, auto x) { return std::atan2(y, x); });
+    }
+    if constexpr(sizeof(typename T::base_type) == sizeof(fxd::i32)) {
+        b.binary_span<T>("hypot[cordic span]", { 0, 10 }, { 0, 10 },
+            [](ct x, ct y, std::span<T> out) { fxd::cordic::hypot(x, y, out); }, [](auto x, auto y) { return std::hypot(x, y); });
+        b.binary_span<T, trig_t>("atan2[cordic span]", any, any,
+            [](ct y, ct x, std::span<trig_t> out) { fxd::cordic::atan2(y, x, out); }, [](auto y, auto x) { return std::atan2(y, x); });
+    }
+
+    // Full tables against the generic path, see table.hpp
+    if constexpr(sizeof(typename T::base_type) <= sizeof(fxd::i16)) {
+        b.unary<T>("sqrt[table]",  positive, [](T x) { return fxd::table::sqrt(x); },  [](auto x) { return std::sqrt(x); });
+        b.unary<T>("rsqrt[table]", positive, [](T x) { return fxd::table::rsqrt(x); }, [](auto x) { return 1 / std::sqrt(x); });
+        b.unary<T>("log2[table]",  positive, [](T x) { return fxd::table::log2(x); },  [](auto x) { return std::log2(x); });
+        b.unary<T>("exp2[table]",  { 0, 4 }, [](T x) { return fxd::table::exp2(x); },  [](auto x) { return std::exp2(x); });
+
+        if constexpr(T::is_signed) {
+            b.unary<T>("sin[table]", { -tau, tau }, [](T x) { return fxd::table::sin(x); }, [](auto x) { return std::sin(x); });
+            b.unary<T>("cos[table]", { -tau, tau }, [](T x) { return fxd::table::cos(x); }, [](auto x) { return std::cos(x); });
+        }
+    }
+
+    // Fitted piecewise polynomials, see piecewise.hpp
+    {
+        using sigmoid_t = fxd::table_function<sigmoid_curve, 64, 3, T>;
+        auto sigmoid = [](auto x) { return 1 / (1 + std::exp(-x)); };
+        b.unary<T>("sigmoid[piecewise]", { -8, 8 }, [](T x) { return sigmoid_t::eval(x); }, sigmoid);
+        if constexpr(sizeof(typename T::base_type) == sizeof(fxd::i32))
+            b.span<T>("sigmoid[piecewise span]", { -8, 8 }, [](ct in, std::span<T> out) { sigmoid_t::eval(in, out); }, sigmoid);
+    }
+    if constexpr(T::is_signed) {
+        using tanh_t = fxd::table_function<tanh_curve, 64, 3, T>;
+        b.unary<T>("tanh[piecewise]", { -4, 4 }, [](T x) { return tanh_t::eval(x); }, [](auto x) { return std::tanh(x); });
+        if constexpr(sizeof(typename T::base_type) == sizeof(fxd::i32))
+            b.span<T>("tanh[piecewise span]", { -4, 4 }, [](ct in, std::span<T> out) { tanh_t::eval(in, out); },
+                [](auto x) { return std::tanh(x); });
+    }
+
+    if constexpr(T::is_signed) {
+        // Trigonometry
+        b.unary<T>("sin",  { -tau, tau }, [](T x) { return fxd::sin(x); },  [](auto x) { return std::sin(x); });
+        b.unary<T>("cos",  { -tau, tau }, [](T x) { return fxd::cos(x); },  [](auto x) { return std::cos(x); });
+        b.unary<T>("tan",  { -1.5, 1.5 }, [](T x) { return fxd::tan(x); },  [](auto x) { return std::tan(x); });
+        b.unary<T>("asin", { -1, 1 },     [](T x) { return fxd::asin(x); }, [](auto x) { return std::asin(x); });
+        b.unary<T>("acos", { -1, 1 },     [](T x) { return fxd::acos(x); }, [](auto x) { return std::acos(x); });
+        b.unary<T>("atan", any,           [](T x) { return fxd::atan(x); }, [](auto x) { return std::atan(x); });
+        b.binary<T>("atan2", any, any,
+            [](T y, T x) { return fxd::atan2(y, x); }, [](auto y, auto x) { return std::atan2(y, x); });
+        b.binary<T>("to_polar", any, any,
+            [](T x, T y) { T r; trig_t t; fxd::to_polar(x, y, r, t); return r + T(t); },
+            [](auto x, auto y) { return std::hypot(x, y) + std::atan2(y, x); });
+        b.binary<T>("from_polar", { 0, 10 }, { -tau / 2, tau / 2 },
+            [](T r, T t) { T x, y; fxd::from_polar(r, trig_t(t), x, y); return x + y; },
+            [](auto r, auto t) { return r * std::cos(t) + r * std::sin(t); });
+        b.unary<T>("sincos", { -tau, tau },
+            [](T x) { trig_t s, c; fxd::sincos(x, s, c); return s + c; },
+            [](auto x) { return std::sin(x) + std::cos(x); });
+        b.unary<T>("sin[wide]", any, [](T x) { return fxd::sin(x); }, [](auto x) { return std::sin(x); });
+        b.unary<T>("cos[wide]", any, [](T x) { return fxd::cos(x); }, [](auto x) { return std::cos(x); });
+        b.unary<T>("sin[wide %tau]", any, [](T x) { x %= fxd::tau<T>; return fxd::sin(x); },
+            [](auto x) { return std::sin(x); });
+        b.unary<T>("cos[wide %tau]", any, [](T x) { x %= fxd::tau<T>; return fxd::cos(x); },
+            [](auto x) { return std::cos(x); });
+        b.unary<T>("sin[angle]", any, [](T x) { return fxd::sin(fxd::angle32(x)); }, [](auto x) { return std::sin(x); });
+        b.unary<T>("cos[angle]", any, [](T x) { return fxd::cos(fxd::angle32(x)); }, [](auto x) { return std::cos(x); });
+        b.unary<T>("sin[cordic]", { -tau, tau }, [](T x) { return fxd::cordic::sin(x); }, [](auto x) { return std::sin(x); });
+        b.unary<T>("sincos[cordic]", { -tau, tau },
+            [](T x) { trig_t s, c; fxd::cordic::sincos(x, s, c); return s + c; },
+            [](auto x) { return std::sin(x) + std::cos(x); });
+        b.unary<T>("sin[fast]", { -tau, tau }, [](T x) { return fxd::fast::sin(x); }, [](auto x) { return std::sin(x); });
+        b.unary<T>("cos[fast]", { -tau, tau }, [](T x) { return fxd::fast::cos(x); }, [](auto x) { return std::cos(x); });
+        b.unary<T>("sin[native]",  { -tau, tau }, [](T x) { return fxd::native::sin(x); },  [](auto x) { return std::sin(x); });
+        b.unary<T>("cos[native]",  { -tau, tau }, [](T x) { return fxd::native::cos(x); },  [](auto x) { return std::cos(x); });
+        b.unary<T>("asin[native]", { -1, 1 },     [](T x) { return fxd::native::asin(x); }, [](auto x) { return std::asin(x); });
+        b.unary<T>("atan[native]", any,           [](T x) { return fxd::native::atan(x); }, [](auto x) { return std::atan(x); });
+
+        if constexpr(sizeof(typename T::base_type) == sizeof(fxd::i32)) {
+            b.span<T, trig_t>("sin[span]", { -tau, tau },
+                [](ct in, std::span<trig_t> out) { fxd::sin(in, out); }, [](auto x) { return std::sin(x); });
+            b.span<T, trig_t>("cos[span]", { -tau, tau },
+                [](ct in, std::span<trig_t> out) { fxd::cos(in, out); }, [](auto x) { return std::cos(x); });
+            b.span<T, trig_t>("sin[cordic span]", { -tau, tau },
+                [](ct in, std::span<trig_t> out) { fxd::cordic::sin(in, out); }, [](auto x) { return std::sin(x); });
+            b.binary_span<T, trig_t>("atan2[span]", any, any,
+                [](ct y, ct x, std::span<trig_t> out) { fxd::atan2(y, x, out); }, [](auto y, auto x) { return std::atan2(y, x); });
+            b.binary_span<T, fxd::angle32>("atan2[angle span]", any, any,
+                [](ct y, ct x, std::span<fxd::angle32> out) { fxd::atan2(y, x, out); },
+                [](auto y, auto x) { return std::atan2(y, x); });
+            b.binary_span<T>("to_polar[span]", any, any,
+                [theta = std::vector<trig_t>(count)](ct x, ct y, std::span<T> out) mutable {
+                    fxd::to_polar(x, y, out, std::span<trig_t>(theta));
+                },
+                [](auto x, auto y) { return std::hypot(x, y) + std::atan2(y, x); });
+            // theta is converted to trig_t once, outside the timing.
+            b.binary_span<T>("from_polar[span]", { 0, 10 }, { -tau / 2, tau / 2 },
+                [theta = std::vector<trig_t>(), y = std::vector<T>(count)](ct r, ct t, std::span<T> out) mutable {
+                    if (theta.empty())
+                        theta.assign(t.begin(), t.end());
+                    fxd::from_polar(r, std::span<const trig_t>(theta), out, std::span<T>(y));
+                },
+                [](auto r, auto t) { return r * std::cos(t) + r * std::sin(t); });
+        }
+    }
+}
+
+void print_table(const std::vector<result>& results) {
+    std::cout << std::left << std::setw(22) << "function" << std::setw(16) << "format"
+              << std::right << std::setw(10) << "lat ns" << std::setw(10) << "tput ns"
+              << std::setw(10) << "float ns" << std::setw(10) << "double ns"
+              << std::setw(10) << "vs float" << std::setw(10) << "vs double" << std::setw(10) << "GB/s"
+              << std::setw(10) << "GOP/s" << '\n';
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(22) << r.function << std::setw(16) << r.format
+                  << std::right << std::setw(10) << r.fixed.latency << std::setw(10) << r.fixed.throughput
+                  << std::setw(10) << r.single.throughput << std::setw(10) << r.dual.throughput
+                  << std::setw(9) << r.single.throughput / r.fixed.throughput << 'x'
+                  << std::setw(9) << r.dual.throughput / r.fixed.throughput << 'x';
+        if (r.bytes > 0)
+            std::cout << std::setw(10) << r.bytes / r.fixed.throughput;
+        else
+            std::cout << std::setw(10) << '-';
+        if (r.ops > 0)
+            std::cout << std::setw(10) << r.ops / r.fixed.throughput << '\n';
+        else
+            std::cout << std::setw(10) << '-' << '\n';
+    }
+}
+
+void print_csv(const std::vector<result>& results) {
+    std::cout << "function,format,fixed_latency_ns,fixed_throughput_ns,float_latency_ns,float_throughput_ns,"
+                 "double_latency_ns,double_throughput_ns,speedup_float,speedup_double,gb_per_s,gop_per_s\n";
+
+    std::cout << std::setprecision(4);
+    for (const auto& r : results) {
+        std::cout << r.function << ',' << r.format << ','
+                  << r.fixed.latency << ',' << r.fixed.throughput << ','
+                  << r.single.latency << ',' << r.single.throughput << ','
+                  << r.dual.latency << ',' << r.dual.throughput << ','
+                  << r.single.throughput / r.fixed.throughput << ','
+                  << r.dual.throughput / r.fixed.throughput << ',';
+        if (r.bytes > 0)
+            std::cout << r.bytes / r.fixed.throughput;
+        std::cout << ',';
+        if (r.ops > 0)
+            std::cout << r.ops / r.fixed.throughput;
+        std::cout << '\n';
+    }
+}
+
+void print_json(const std::vector<result>& results) {
+    auto timing_json = [](const timing& t) {
+        std::cout << "{\"latency_ns\": " << t.latency << ", \"throughput_ns\": " << t.throughput << '}';
+    };
+
+    std::cout << std::setprecision(4) << "[\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        std::cout << "  {\"function\": \"" << r.function << "\", \"format\": \"" << r.format << "\", \"fixed\": ";
+        timing_json(r.fixed);
+        std::cout << ", \"float\": ";
+        timing_json(r.single);
+        std::cout << ", \"double\": ";
+        timing_json(r.dual);
+        std::cout << ", \"speedup_float\": " << r.single.throughput / r.fixed.throughput
+                  << ", \"speedup_double\": " << r.dual.throughput / r.fixed.throughput << ", \"gb_per_s\": ";
+        if (r.bytes > 0)
+            std::cout << r.bytes / r.fixed.throughput;
+        else
+            std::cout << "null";
+        std::cout << ", \"gop_per_s\": ";
+        if (r.ops > 0)
+            std::cout << r.ops / r.fixed.throughput;
         else
-            i += 33.268728988253;
-    }
-    std::cout << max_error * 100 << "% max rerror\n";*/
-
-    /*for (real i = -M_PI * 2; i <= M_PI * 2; i += M_PI/16) {
-        real result = (real)fxd::cos<int, 24>(i);
-        real expect = std::cos(i);
-        real rerror = (result - expect) / expect;
-        auto out = std::format("i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, result, expect, 100.0 * rerror);
-        std::cout << out;
-
-        if (std::abs(rerror) > max_error)
-            max_error = std::abs(rerror);
-    }
-    std::cout << max_error * 100 << "% max rerror\n";*/
-
-    /*for (real i = start; i < end; i += 14.31257891) {
-        real result = (real)fxd::rcp<int, 20>(i);
-        real expect = 1.0 / i;
-        auto out = std::format("i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, result, expect, 100.0 * std::abs((result - expect)/expect));
-        std::cout << out;
-    }*/
-
-    /*for (real i = start; i < end; i += 17.157891356) {
-        real result = (real)fxd::sqrt(fxd::fixed20(i));
-        real expect = sqrt(i);
-        auto out = std::format("i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, result, expect, 100.0 * std::abs((result - expect)/expect));
-        std::cout << out;
-    }*/
-
-    /*for (real i = start; i < end; i += 17.157891356) {
-        real result = (real)fxd::rsqrt(fxd::fixed20(i));
-        real expect = 1.0 / sqrt(i);
-        auto out = std::format("i: {: .4f}, fixed: {: .10f}, real: {: .10f}, rerror: {: .6f}%\n",
-            i, result, expect, 100.0 * std::abs((result - expect)/expect));
-        std::cout << out;
-    }*/
-}
\ No newline at end of file
+            std::cout << "null";
+        std::cout << '}' << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    options opt;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (arg == "--csv")
+            opt.output = options::csv;
+        else if (arg == "--json")
+            opt.output = options::json;
+        else if (arg.starts_with("--filter="))
+            opt.filter = arg.substr(9);
+        else if (arg.starts_with("--min-time="))
+            opt.min_time_ms = std::stod(std::string(arg.substr(11)));
+        else {
+            std::cerr << "usage: " << argv[0] << " [--csv | --json] [--filter=<text>] [--min-time=<ms>]\n";
+            return 1;
+        }
+    }
+
+    std::vector<result> results;
+    run_format<fxd::hfixed8>(opt, results, "hfixed8");
+    run_format<fxd::hfixed12>(opt, results, "hfixed12");
+    run_format<fxd::uhfixed8>(opt, results, "uhfixed8");
+    run_format<fxd::uhfixed12>(opt, results, "uhfixed12");
+    run_format<fxd::fixed8>(opt, results, "fixed8");
+    run_format<fxd::fixed12>(opt, results, "fixed12");
+    run_format<fxd::fixed16>(opt, results, "fixed16");
+    run_format<fxd::fixed18>(opt, results, "fixed18");
+    run_format<fxd::fixed20>(opt, results, "fixed20");
+    run_format<fxd::fixed24>(opt, results, "fixed24");
+    run_format<fxd::ufixed8>(opt, results, "ufixed8");
+    run_format<fxd::ufixed12>(opt, results, "ufixed12");
+    run_format<fxd::ufixed16>(opt, results, "ufixed16");
+    run_format<fxd::ufixed18>(opt, results, "ufixed18");
+    run_format<fxd::ufixed20>(opt, results, "ufixed20");
+    run_format<fxd::ufixed24>(opt, results, "ufixed24");
+    run_format<fxd::exp_t>(opt, results, "exp_t");
+    run_format<fxd::trig_t>(opt, results, "trig_t");
+    run_format<fxd::frac_t>(opt, results, "frac_t");
+    run_format<fxd::fixed<fxd::i64, 32>>(opt, results, "fixed<i64,32>");
+
+    switch (opt.output) {
+        case options::csv:  print_csv(results);   break;
+        case options::json: print_json(results);  break;
+        default:            print_table(results); break;
+    }
+}
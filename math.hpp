@@ -6,6 +6,7 @@
 #include "./fixed.hpp"
 #include "./const.hpp"
 #include "./math_helper.hpp"
+#include "./table.hpp"
 
 namespace fxd {
 
@@ -39,11 +40,11 @@ template<std::integral base, int fp>
 constexpr fixed<base, fp> ceil(fixed<base, fp> s) {
     if constexpr(fixed<base, fp>::is_signed) {
         if (s > 0) 
-            s += fixed<base, fp>::max_fraction();
+            s += fixed<base, fp>::max_frac();
         return trunc(s);
     }
     else {
-        return trunc(s + fixed<base, fp>::max_fraction());
+        return trunc(s + fixed<base, fp>::max_frac());
     }
 }
 
@@ -51,7 +52,7 @@ template<std::integral base, int fp>
 constexpr fixed<base, fp> floor(fixed<base, fp> s) {
     if constexpr(fixed<base, fp>::is_signed) {
         if (s < 0) 
-            s -= fixed<base, fp>::max_fraction();
+            s -= fixed<base, fp>::max_frac();
         return trunc(s);
     }
     else {
@@ -90,7 +91,10 @@ constexpr fixed<base, fp> smoothstep(fixed<base, fp> x, decltype(x) edge0, declt
 
 // Exponents
 
-template<std::integral base, int fp>
+// sqrt, rsqrt, rcp and rcp_ext take an optional table size and Newton step
+// count, as in sqrt<1024, 1>(x). The defaults are a 128-entry table and two steps.
+
+template<int size, int iterations, std::integral base, int fp> requires impl::lut_size<size>
 constexpr fixed<base, fp> sqrt(fixed<base, fp> s) {
     using fixed_t = fixed<base, fp>;
 
@@ -99,11 +103,11 @@ constexpr fixed<base, fp> sqrt(fixed<base, fp> s) {
 
     const int log2 = impl::ilog2(s.raw()) - fp;
     const high_t x = ((log2 > 0) ? (s >> log2) : (s << -log2)) >> 1;
-    const int idx = (x & (0xfe << 17)).raw() >> 18;
+    const int idx = impl::lut_index<size, 25>(x.raw());
 
-    high_t y = high_t::from_raw(impl::rsqrt_lut[idx] >> 5);
-    y *= 1.5 - (x * y * y);
-    y *= 1.5 - (x * y * y);
+    high_t y = high_t::from_raw(impl::rsqrt_table<size>[idx] >> 5);
+    for (int i = 0; i < iterations; i++)
+        y *= 1.5 - (x * y * y);
 
     y *= (x << 1);
 
@@ -115,7 +119,16 @@ constexpr fixed<base, fp> sqrt(fixed<base, fp> s) {
     return (log2 > 0) ? (out << (log2 >> 1)) : (out >> (-log2 >> 1));
 }
 
-template<std::integral base, int fp>
+template<std::integral base, int fp, bool tables = true>
+constexpr fixed<base, fp> sqrt(fixed<base, fp> s) {
+    if constexpr(tables && impl::full_tables<base>)
+        if (!std::is_constant_evaluated())
+            return impl::full_table_lookup<impl::sqrt_fn>(s);
+
+    return sqrt<128, 2>(s);
+}
+
+template<int size, int iterations, std::integral base, int fp> requires impl::lut_size<size>
 constexpr fixed<base, fp> rsqrt(fixed<base, fp> s) {
     using fixed_t = fixed<base, fp>;
 
@@ -124,11 +137,11 @@ constexpr fixed<base, fp> rsqrt(fixed<base, fp> s) {
 
     const int log2 = impl::ilog2(s.raw()) - fp;
     const high_t x = ((log2 > 0) ? (s >> log2) : (s << -log2)) >> 1;
-    const int idx = (x & (0xfe << 17)).raw() >> 18;
+    const int idx = impl::lut_index<size, 25>(x.raw());
 
-    high_t y = high_t::from_raw(impl::rsqrt_lut[idx] >> 5);
-    y *= 1.5 - (x * y * y);
-    y *= 1.5 - (x * y * y);
+    high_t y = high_t::from_raw(impl::rsqrt_table<size>[idx] >> 5);
+    for (int i = 0; i < iterations; i++)
+        y *= 1.5 - (x * y * y);
 
     if (log2 & 1)
         y *= (log2 > 0) ? rsqrt_2<high_t> : sqrt_2<high_t>;
@@ -137,7 +150,16 @@ constexpr fixed<base, fp> rsqrt(fixed<base, fp> s) {
     return (log2 > 0) ? (out >> (log2 >> 1)) : (out << (-log2 >> 1));
 }
 
-template<std::integral base, int fp>
+template<std::integral base, int fp, bool tables = true>
+constexpr fixed<base, fp> rsqrt(fixed<base, fp> s) {
+    if constexpr(tables && impl::full_tables<base>)
+        if (!std::is_constant_evaluated())
+            return impl::full_table_lookup<impl::rsqrt_fn>(s);
+
+    return rsqrt<128, 2>(s);
+}
+
+template<int size, int iterations, std::integral base, int fp> requires impl::lut_size<size>
 constexpr fixed<base, fp> rcp(fixed<base, fp> s) {
     using fixed_t = fixed<base, fp>;
 
@@ -145,45 +167,55 @@ constexpr fixed<base, fp> rcp(fixed<base, fp> s) {
         return fixed_t::max();
 
     if (s < 0)
-        return -rcp(-s);
+        return -rcp<size, iterations>(-s);
 
     const int log2 = impl::ilog2(s.raw()) - fp;
     const high_t x = (log2 > 0) ? (s >> log2) : (s << -log2);
-    const int idx = (x & (0xfe << 18)).raw() >> 19;
+    const int idx = impl::lut_index<size, 26>(x.raw());
 
-    high_t y = high_t::from_raw(impl::rcp_lut[idx] >> 5);
-    y *= (2 - x * y);
-    y *= (2 - x * y);
+    high_t y = high_t::from_raw(impl::rcp_table<size>[idx] >> 5);
+    for (int i = 0; i < iterations; i++)
+        y *= (2 - x * y);
 
     fixed_t out = y;
     return (log2 > 0) ? (out >> log2) : (out << -log2);
 }
 
+template<std::integral base, int fp>
+constexpr fixed<base, fp> rcp(fixed<base, fp> s) {
+    return rcp<128, 2>(s);
+}
+
 // Extended reciprocal for max precision.
 // All inputs MUST be above 1.
 
-template<std::integral base, int fp>
+template<int size, int iterations, std::integral base, int fp> requires impl::lut_size<size>
 constexpr frac_t rcp_ext(fixed<base, fp> s) {
     if (s == 0)
         return frac_t::max();
 
     if (s < 0)
-        return -rcp_ext(-s);
+        return -rcp_ext<size, iterations>(-s);
 
     if (s < 1)
         return 0;
 
     const int log2 = impl::ilog2(s.raw()) - fp;
     const frac_t x = s >> log2;
-    const int idx = (x & (0xfe << 20)).raw() >> 21;
+    const int idx = impl::lut_index<size, 28>(x.raw());
 
-    frac_t y = frac_t::from_raw(impl::rcp_lut[idx] >> 3);
-    y *= (2 - x * y);
-    y *= (2 - x * y);
+    frac_t y = frac_t::from_raw(impl::rcp_table<size>[idx] >> 3);
+    for (int i = 0; i < iterations; i++)
+        y *= (2 - x * y);
 
     return y >> log2;
 }
 
+template<std::integral base, int fp>
+constexpr frac_t rcp_ext(fixed<base, fp> s) {
+    return rcp_ext<128, 2>(s);
+}
+
 template<std::integral base, int fp>
 constexpr fixed<base, fp> hypot(fixed<base, fp> x, fixed<base, fp> y) {
     return sqrt(x * x + y * y);
@@ -196,68 +228,75 @@ constexpr fixed<base, fp> hypot(fixed<base, fp> x, fixed<base, fp> y, fixed<base
 
 // Logarithms
 
-template<std::integral base, int fp, bool highp = true>
-constexpr exp_t log2(fixed<base, fp> s) {
-    using impl::log_t;
-    
+template<std::integral base, int fp, bool highp = true, bool tables = true>
+constexpr impl::exp_result_t<base> log2(fixed<base, fp> s) {
+    using impl::log_t, impl::log2_c1, impl::log2_c2, impl::log2_c3, impl::log2_c4, impl::log2_c5, impl::log2_c6;
+    using exp_t = impl::exp_result_t<base>;
+
+    if constexpr(tables && impl::full_tables<base>)
+        if (!std::is_constant_evaluated())
+            return impl::full_table_lookup<impl::log2_fn>(s);
+
     if (s <= 0)
         return exp_t::min();
 
     const int log2 = impl::ilog2(s.raw()) - fp;
 
     const log_t x = impl::log2_sqrt((log2 > 0) ? (s >> log2) : (s << -log2));
-    constexpr log_t c1 =  0.11598391789742051872;
-    constexpr log_t c2 = -0.87468467888034107105;
-    constexpr log_t c3 =  2.80670941352567426819;
-    constexpr log_t c4 = -5.05195558416252410439;
-    constexpr log_t c5 =  6.04525303940652847245;
-    constexpr log_t c6 = -3.04130610778675780637;
-    const log_t y = x * (x * (x * (x * (c1 * x + c2) + c3) + c4) + c5) + c6;
+    const log_t y = x * (x * (x * (x * (log2_c1 * x + log2_c2) + log2_c3) + log2_c4) + log2_c5) + log2_c6;
     return log2 + static_cast<exp_t>(y << 1);
 }
 
 template<std::integral base, int fp>
-constexpr exp_t log(fixed<base, fp> s) {
-    return log2(s) * ln2<exp_t>;
+constexpr impl::exp_result_t<base> log(fixed<base, fp> s) {
+    return log2(s) * ln2<impl::exp_result_t<base>>;
 }
 
 template<std::integral base, int fp>
-constexpr exp_t log10(fixed<base, fp> s) {
-    return log2(s) * log10_2<exp_t>;
+constexpr impl::exp_result_t<base> log10(fixed<base, fp> s) {
+    return log2(s) * log10_2<impl::exp_result_t<base>>;
 }
 
 // Powers
 
-template<std::integral base, int fp>    
+// 2^(s * multiplier). The product keeps every bit, so exp and exp10 split
+// their exponent into whole and fraction parts exactly.
+template<std::integral base, int fp, bool tables = true>
 constexpr fixed<base, fp> exp2(fixed<base, fp> s, exp_t multiplier = 1.0) {
-    using fixed_t = fixed<base, fp>;    
+    using fixed_t = fixed<base, fp>;
+    using wide_t = std::conditional_t<(sizeof(base) > sizeof(i32)), i128, i64>;
+    constexpr int f = exp_t::frac_bits;
 
-    if (s == 0)
+    if constexpr(tables && impl::full_tables<base>)
+        if (!std::is_constant_evaluated() && multiplier == 1)
+            return impl::full_table_lookup<impl::exp2_fn>(s);
+
+    const wide_t p = static_cast<wide_t>(s.raw()) * multiplier.raw();
+    if (p == 0)
         return 1;
 
     constexpr fixed_t max_exp = log2(fixed_t::max());
     constexpr fixed_t min_exp = impl::get_min_exp2_input<base, fp>();
-    if (s >= max_exp)
+    if (p >= (static_cast<wide_t>(max_exp.raw()) << f))
         return fixed_t::max();
-    if (s <= min_exp)
+    if (p <= (static_cast<wide_t>(min_exp.raw()) << f))
         return fixed_t::min_frac();
 
     auto approx = [] (exp_t x) -> exp_t {
+        using impl::exp2_c1, impl::exp2_c2;
         x *= ln2<exp_t>;
-        constexpr exp_t c1 = exp_t(1) / 3;
-        constexpr exp_t c2 = exp_t(1) / 5;
-        return 1 + x * (1 + (x >> 1) * (1 + x * c1 * (1 + (x >> 2) * (1 + x * c2))));
+        return 1 + x * (1 + (x >> 1) * (1 + x * exp2_c1 * (1 + (x >> 2) * (1 + x * exp2_c2))));
     };
 
-    if (s > 0) {
-        const exp_t x = static_cast<exp_t>(s.frac()) * multiplier;
-        return (fixed_t(1) << int(s)) * static_cast<fixed_t>(approx(x));
-    }
-    else {
-        s = -s;
-        const exp_t x = static_cast<exp_t>(s.frac()) * multiplier;
-        return (fixed_t(1) >> int(s)) * static_cast<fixed_t>(approx(-x));
-    }
+    // |p| = n + x, with n whole and x: [0, 1) in exp_t.
+    const wide_t a = (p < 0) ? -p : p;
+    const int n = static_cast<int>(a >> (fp + f));
+    const exp_t x = exp_t::from_raw(static_cast<i32>((a >> fp) & ((wide_t(1) << f) - 1)));
+
+    if (p > 0)
+        return (fixed_t(1) << n) * static_cast<fixed_t>(approx(x));
+    else
+        return (fixed_t(1) >> n) * static_cast<fixed_t>(approx(-x));
 }
 
 template<std::integral base, int fp>    
@@ -273,18 +312,19 @@ constexpr fixed<base, fp> exp10(fixed<base, fp> x) {
 template<std::integral base, int fp>    
 constexpr fixed<base, fp> pow(fixed<base, fp> x, exp_t y) {
     using fixed_t = fixed<base, fp>;
+    using exp_t = impl::exp_result_t<base>;
 
     if (x == 0)
         return 0;
 
     if (x > 0)
-        return exp2(y * log2(x));
+        return exp2(exp_t(y) * log2(x));
     else {
         if (y.frac() == 0)
-            if (y & 1)
-                return -exp2(y * log2(-x));
+            if (int(y) & 1)
+                return -exp2(exp_t(y) * log2(-x));
             else
-                return  exp2(y * log2(-x));
+                return  exp2(exp_t(y) * log2(-x));
         else
             return fixed_t::min();
     }
@@ -292,7 +332,7 @@ constexpr fixed<base, fp> pow(fixed<base, fp> x, exp_t y) {
 
 template<std::integral base, int fp>
 constexpr fixed<base, fp> cbrt(fixed<base, fp> s) {
-    using fixed_t = fixed<base, fp>;
+    using exp_t = impl::exp_result_t<base>;
     constexpr exp_t mul = exp_t(1) / 3;
     if (s > 0)
         return exp2(log2(s) * mul);
@@ -304,71 +344,54 @@ constexpr fixed<base, fp> cbrt(fixed<base, fp> s) {
 
 // Trigonometry
 
-template<std::integral base, int fp>
+template<std::integral base, int fp, bool tables = true>
 constexpr trig_t sin(fixed<base, fp> s) {
     static_assert(fixed<base, fp>::is_signed, "sin only supports signed fixed types!");
 
-    if (s < 0)
-        return -sin(-s);
-
-    if (s > tau<decltype(s)>)
-        s %= tau<decltype(s)>;
-
-    trig_t x = s;
+    if constexpr(tables && impl::full_tables<base>)
+        if (!std::is_constant_evaluated())
+            return impl::full_table_lookup<impl::sin_fn>(s);
 
-    const int sector = ((x + impl::p1) * impl::pstep).raw() >> trig_t::frac_bits;
-    const bool sin_sign = x <= impl::p3 || x > impl::p7;
+    int quadrant;
+    const trig_t x = impl::reduce_half_pi(s, quadrant);
 
-    x -= half_pi<trig_t> * sector;
-
-    const trig_t out_sin = (sector & 1) ? impl::get_cos(x) : impl::get_sin(x);
-    return sin_sign ? out_sin : -out_sin;
+    const trig_t out_sin = (quadrant & 1) ? impl::get_cos(x) : impl::get_sin(x);
+    return ((quadrant & 2) != 0) != (s < 0) ? -out_sin : out_sin;
 }
 
-template<std::integral base, int fp>
+template<std::integral base, int fp, bool tables = true>
 constexpr trig_t cos(fixed<base, fp> s) {
     static_assert(fixed<base, fp>::is_signed, "cos only supports signed fixed types!");
 
-    s = (s < 0) ? -s : s;
-
-    if (s > tau<decltype(s)>)
-        s %= tau<decltype(s)>;
+    if constexpr(tables && impl::full_tables<base>)
+        if (!std::is_constant_evaluated())
+            return impl::full_table_lookup<impl::cos_fn>(s);
 
-    trig_t x = s;
+    int quadrant;
+    const trig_t x = impl::reduce_half_pi(s, quadrant);
 
-    const int sector = ((x + impl::p1) * impl::pstep).raw() >> trig_t::frac_bits;
-    const bool cos_sign = x <= impl::p1 || x > impl::p5;
-
-    x -= half_pi<trig_t> * sector;
-
-    const trig_t out_cos = (sector & 1) ? impl::get_sin(x) : impl::get_cos(x);
-    return cos_sign ? out_cos : -out_cos;
+    const trig_t out_cos = (quadrant & 1) ? impl::get_sin(x) : impl::get_cos(x);
+    return (quadrant == 1 || quadrant == 2) ? -out_cos : out_cos;
 }
 
-template<std::integral base, int fp>
+template<std::integral base, int fp, bool tables = true>
 constexpr void sincos(fixed<base, fp> s, trig_t& out_sin, trig_t& out_cos) {
     static_assert(fixed<base, fp>::is_signed, "sincos only supports signed fixed types!");
 
-    if (s < 0) {
-        sincos(-s, out_sin, out_cos);
-        out_sin = -out_sin;
-        return;
+    if constexpr(tables && impl::full_tables<base>) {
+        if (!std::is_constant_evaluated()) {
+            out_sin = impl::full_table_lookup<impl::sin_fn>(s);
+            out_cos = impl::full_table_lookup<impl::cos_fn>(s);
+            return;
+        }
     }
-    
-    if (s > tau<decltype(s)>)
-        s %= tau<decltype(s)>;
-
-    trig_t x = s;
-
-    // Sectors in intervals of pi/2, with x initially offset by pi/4.
-    const int sector = ((x + impl::p1) * impl::pstep).raw() >> trig_t::frac_bits;
-    const bool cos_sign = x <= impl::p1 || x > impl::p5;
-    const bool sin_sign = x <= impl::p3 || x > impl::p7;
 
-    x -= half_pi<trig_t> * sector;
+    // Quarter turns of |s|, with x: [-pi/4, pi/4] left over.
+    int quadrant;
+    const trig_t x = impl::reduce_half_pi(s, quadrant);
 
-    // Odd sector = flip inputs
-    if (sector & 1) {
+    // Odd quadrant = flip inputs
+    if (quadrant & 1) {
         out_cos = impl::get_sin(x);
         out_sin = impl::get_cos(x);
     }
@@ -377,8 +400,8 @@ constexpr void sincos(fixed<base, fp> s, trig_t& out_sin, trig_t& out_cos) {
         out_sin = impl::get_sin(x);
     }
 
-    out_cos = cos_sign ? out_cos : -out_cos;
-    out_sin = sin_sign ? out_sin : -out_sin;
+    out_cos = (quadrant == 1 || quadrant == 2) ? -out_cos : out_cos;
+    out_sin = ((quadrant & 2) != 0) != (s < 0) ? -out_sin : out_sin;
 }
 
 template<std::integral base, int fp>
@@ -395,10 +418,13 @@ constexpr fixed<base, fp> tan(fixed<base, fp> s) {
 
 template<std::integral base, int fp>
 constexpr trig_t asin(fixed<base, fp> s) {
-    const trig_t x = s;
-
-    if (x > 1)
+    // Compare before narrowing, which would wrap large inputs.
+    if (s > 1)
         return trig_t::max();
+    if (s < -1)
+        return -trig_t::max();
+
+    const trig_t x = s;
     if (x > 0.5)
         return half_pi<trig_t> - (asin(impl::asin_sqrt((1 - x) >> 1)) << 1);
     if (x < 0)
@@ -423,52 +449,155 @@ constexpr trig_t atan(fixed<base, fp> s) {
     if (s < 0)
         return -atan(-s);
 
-    auto atan01 = [] (trig_t x) -> trig_t {
-        if (x <= 0.375) {
-            constexpr trig_t c1 = trig_t(1) / 3;
-            constexpr trig_t c2 = trig_t(1) / 5;
-            constexpr trig_t c3 = trig_t(1) / 7;
-            constexpr trig_t c4 = trig_t(1) / 9;
-            const trig_t x2 = x * x;
-            return x * (1 - x2 * (c1 - x2 * (c2 - x2 * (c3 - x2 * c4))));
-        }
-        else {
-            constexpr trig_t c1 = -0.07277922440465403597;
-            constexpr trig_t c2 =  0.33012363557510843171;
-            constexpr trig_t c3 = -0.52029663001374293341;
-            constexpr trig_t c4 =  0.05631084241194499879;
-            constexpr trig_t c5 =  0.99158187828010724285;
-            constexpr trig_t c6 =  0.00045766154868510445;
-            return x * (x * (x * (x * (c1 * x + c2) + c3) + c4) + c5) + c6;
-        }
-    };
-
     if (s <= 1)
-        return atan01(s);
+        return impl::atan01(s);
     else
-        return half_pi<trig_t> - atan01(rcp_ext(s));
+        return half_pi<trig_t> - impl::atan01(rcp_ext(s));
 }
 
+// Folds (x, y) into the first octant, where one division of the smaller
+// magnitude by the larger gives t: [0, 1], and unfolds atan(t) with
+// pi/2 - a, pi - a and the sign of y. atan2(0, 0) is 0.
 template<std::integral base, int fp>
 constexpr trig_t atan2(fixed<base, fp> y, fixed<base, fp> x) {
-    if (x == 0)
-        return y >= 0 ? half_pi<trig_t> : -half_pi<trig_t>;
+    const auto ax = impl::magnitude(x);
+    const auto ay = impl::magnitude(y);
+    if (ax == 0 && ay == 0)
+        return 0;
 
-    const auto ratio = y * rcp(x);
-    const int sign_y = sign(y);
-    if (sign(ratio) != (sign_y * sign(x))) // Overflow
-        return (sign_y >= 0) ? half_pi<trig_t> : -half_pi<trig_t>;
+    const bool steep = ay > ax;
+    trig_t a = steep ? impl::octant_ratio(ax, ay) : impl::octant_ratio(ay, ax);
+    a = impl::atan01(a);
+    if (steep)
+        a = half_pi<trig_t> - a;
 
-    const trig_t val = atan(ratio);
+    if constexpr(fixed<base, fp>::is_signed) {
+        if (x < 0)
+            a = pi<trig_t> - a;
+        if (y < 0)
+            a = -a;
+    }
+    return a;
+}
 
-    if (x < 0) {
-        if (y >= 0)
-            return val + pi<trig_t>;
-        else
-            return val - pi<trig_t>;
+// Polar coordinates
+
+// r and theta of (x, y), sharing the octant division of atan2:
+// r = max(|x|, |y|) * sqrt(1 + t^2), which cannot overflow before r does.
+template<std::integral base, int fp>
+constexpr void to_polar(fixed<base, fp> x, fixed<base, fp> y, fixed<base, fp>& out_r, trig_t& out_theta) {
+    using fixed_t = fixed<base, fp>;
+
+    const auto ax = impl::magnitude(x);
+    const auto ay = impl::magnitude(y);
+    const auto hi = std::max(ax, ay);
+    if (hi == 0) {
+        out_r = 0;
+        out_theta = 0;
+        return;
     }
-    else
-        return val;
+
+    const trig_t t = impl::octant_ratio(std::min(ax, ay), hi);
+    out_r = fixed_t::from_raw(impl::mul_trig<base>(hi, sqrt(1 + t * t)));
+
+    trig_t a = impl::atan01(t);
+    if (ay > ax)
+        a = half_pi<trig_t> - a;
+
+    if constexpr(fixed_t::is_signed) {
+        if (x < 0)
+            a = pi<trig_t> - a;
+        if (y < 0)
+            a = -a;
+    }
+    out_theta = a;
+}
+
+template<std::integral base, int fp>
+constexpr void from_polar(fixed<base, fp> r, trig_t theta, fixed<base, fp>& out_x, fixed<base, fp>& out_y) {
+    using fixed_t = fixed<base, fp>;
+    static_assert(fixed_t::is_signed, "from_polar only supports signed fixed types!");
+
+    trig_t sin, cos;
+    sincos(theta, sin, cos);
+    out_x = fixed_t::from_raw(impl::mul_trig<base>(r.raw(), cos));
+    out_y = fixed_t::from_raw(impl::mul_trig<base>(r.raw(), sin));
+}
+
+// Full tables, see table.hpp.
+
+namespace impl {
+
+struct sin_fn {
+    static double reference(double x) { return std::sin(x); }
+
+    template<std::integral base, int fp>
+    static trig_t generic(fixed<base, fp> x) { return sin<base, fp, false>(x); }
+};
+
+struct cos_fn {
+    static double reference(double x) { return std::cos(x); }
+
+    template<std::integral base, int fp>
+    static trig_t generic(fixed<base, fp> x) { return cos<base, fp, false>(x); }
+};
+
+struct sqrt_fn {
+    static double reference(double x) { return std::sqrt(x); }
+
+    template<std::integral base, int fp>
+    static fixed<base, fp> generic(fixed<base, fp> x) { return sqrt<base, fp, false>(x); }
+};
+
+struct rsqrt_fn {
+    static double reference(double x) { return 1 / std::sqrt(x); }
+
+    template<std::integral base, int fp>
+    static fixed<base, fp> generic(fixed<base, fp> x) { return rsqrt<base, fp, false>(x); }
+};
+
+struct exp2_fn {
+    static double reference(double x) { return std::exp2(x); }
+
+    template<std::integral base, int fp>
+    static fixed<base, fp> generic(fixed<base, fp> x) { return exp2<base, fp, false>(x); }
+};
+
+struct log2_fn {
+    static double reference(double x) { return std::log2(x); }
+
+    template<std::integral base, int fp>
+    static exp_result_t<base> generic(fixed<base, fp> x) { return log2<base, fp, true, false>(x); }
+};
+
 }
 
-}
\ No newline at end of file
+namespace table {
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i16))
+trig_t sin(fixed<base, fp> s) { return impl::full_table_lookup<impl::sin_fn>(s); }
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i16))
+trig_t cos(fixed<base, fp> s) { return impl::full_table_lookup<impl::cos_fn>(s); }
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i16))
+void sincos(fixed<base, fp> s, trig_t& out_sin, trig_t& out_cos) {
+    out_sin = impl::full_table_lookup<impl::sin_fn>(s);
+    out_cos = impl::full_table_lookup<impl::cos_fn>(s);
+}
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i16))
+fixed<base, fp> sqrt(fixed<base, fp> s) { return impl::full_table_lookup<impl::sqrt_fn>(s); }
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i16))
+fixed<base, fp> rsqrt(fixed<base, fp> s) { return impl::full_table_lookup<impl::rsqrt_fn>(s); }
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i16))
+fixed<base, fp> exp2(fixed<base, fp> s) { return impl::full_table_lookup<impl::exp2_fn>(s); }
+
+template<std::integral base, int fp> requires (sizeof(base) <= sizeof(i16))
+impl::exp_result_t<base> log2(fixed<base, fp> s) { return impl::full_table_lookup<impl::log2_fn>(s); }
+
+}
+
+}
@@ -1,93 +1,222 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <bit>
 #include <cstdint>
+#include <type_traits>
 
 #include "./fixed.hpp"
 #include "./const.hpp"
 
 namespace fxd::impl {
 
-// Uses the first 7 fraction bits to lookup an initial estimate.
-// All lookup tables are in unsigned Q1.31 format.
-
-constexpr inline u32 rsqrt_lut[128] = {
-    2147483648, 2139143874, 2130900514, 2122751725, 2114695712, 2106730728, 2098855072, 2091067086, 
-    2083365155, 2075747706, 2068213207, 2060760162, 2053387115, 2046092644, 2038875363, 2031733921, 
-    2024666999, 2017673310, 2010751597, 2003900635, 1997119226, 1990406201, 1983760419, 1977180764, 
-    1970666148, 1964215505, 1957827795, 1951502002, 1945237132, 1939032213, 1932886295, 1926798449, 
-    1920767766, 1914793358, 1908874353, 1903009902, 1897199171, 1891441346, 1885735627, 1880081235, 
-    1874477403, 1868923384, 1863418443, 1857961862, 1852552937, 1847190978, 1841875309, 1836605269, 
-    1831380208, 1826199490, 1821062491, 1815968600, 1810917217, 1805907755, 1800939636, 1796012295, 
-    1791125178, 1786277739, 1781469446, 1776699774, 1771968208, 1767274244, 1762617387, 1757997150, 
-    1753413056, 1748864635, 1744351429, 1739872984, 1735428857, 1731018611, 1726641819, 1722298059, 
-    1717986918, 1713707990, 1709460876, 1705245183, 1701060526, 1696906525, 1692782810, 1688689012, 
-    1684624773, 1680589738, 1676583558, 1672605893, 1668656405, 1664734763, 1660840641, 1656973719, 
-    1653133683, 1649320220, 1645533028, 1641771804, 1638036255, 1634326089, 1630641020, 1626980766, 
-    1623345050, 1619733599, 1616146145, 1612582423, 1609042172, 1605525135, 1602031061, 1598559701, 
-    1595110808, 1591684143, 1588279467, 1584896547, 1581535150, 1578195051, 1574876026, 1571577852, 
-    1568300314, 1565043197, 1561806289, 1558589383, 1555392273, 1552214757, 1549056637, 1545917714, 
-    1542797796, 1539696692, 1536614213, 1533550174, 1530504391, 1527476684, 1524466875, 1521474788
-};
+// Lookup tables of initial estimates over a mantissa m in [1, 2), indexed by
+// the top log2(size) fraction bits of m. All entries are unsigned Q1.31, and
+// any power of two from 64 to 4096 entries can be generated at compile time.
+// Larger tables trade L1 footprint for fewer Newton steps.
 
-constexpr inline u32 rcp_lut[128] = {
-    2147483648, 2130836487, 2114445438, 2098304633, 2082408385, 2066751180, 2051327663, 2036132644,
-    2021161080, 2006408079, 1991868890, 1977538898, 1963413621, 1949488701, 1935759908, 1922223125,
-    1908874353, 1895709703, 1882725390, 1869917734, 1857283155, 1844818167, 1832519379, 1820383489,
-    1808407282, 1796587627, 1784921473, 1773405851, 1762037865, 1750814693, 1739733588, 1728791867,
-    1717986918, 1707316192, 1696777203, 1686367527, 1676084798, 1665926708, 1655891005, 1645975490,
-    1636178017, 1626496490, 1616928864, 1607473140, 1598127365, 1588889635, 1579758085, 1570730896,
-    1561806289, 1552982525, 1544257904, 1535630765, 1527099483, 1518662469, 1510318170, 1502065065,
-    1493901668, 1485826524, 1477838209, 1469935331, 1462116526, 1454380460, 1446725826, 1439151345,
-    1431655765, 1424237859, 1416896427, 1409630292, 1402438300, 1395319324, 1388272257, 1381296014,
-    1374389534, 1367551775, 1360781717, 1354078359, 1347440720, 1340867838, 1334358771, 1327912593,
-    1321528398, 1315205296, 1308942414, 1302738895, 1296593900, 1290506605, 1284476200, 1278501892,
-    1272582902, 1266718465, 1260907830, 1255150260, 1249445031, 1243791434, 1238188770, 1232636354,
-    1227133513, 1221679586, 1216273924, 1210915889, 1205604855, 1200340204, 1195121334, 1189947649,
-    1184818564, 1179733506, 1174691910, 1169693221, 1164736893, 1159822392, 1154949188, 1150116765,
-    1145324612, 1140572227, 1135859119, 1131184802, 1126548798, 1121950640, 1117389865, 1112866020,
-    1108378657, 1103927337, 1099511627, 1095131103, 1090785345, 1086473940, 1082196484, 1077952576
-};
+template<int size>
+concept lut_size = size >= 64 && size <= 4096 && std::has_single_bit(unsigned(size));
+
+// floor(sqrt(n)), one bit at a time.
+consteval u64 isqrt(u64 n) {
+    u64 root = 0;
+    for (u64 bit = u64(1) << 62; bit != 0; bit >>= 2) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+    }
+    return root;
+}
+
+// floor(2^31 / sqrt(1 + i / size)), computed as floor(sqrt(floor(2^62 * size / (size + i)))).
+template<int size> requires lut_size<size>
+consteval std::array<u32, size> make_rsqrt_lut() {
+    std::array<u32, size> out{};
+    for (int i = 0; i < size; i++)
+        out[i] = static_cast<u32>(isqrt(static_cast<u64>((u128(1) << 62) * size / (size + i))));
+    return out;
+}
+
+// floor(2^31 / (1 + i / size)).
+template<int size> requires lut_size<size>
+consteval std::array<u32, size> make_rcp_lut() {
+    std::array<u32, size> out{};
+    for (int i = 0; i < size; i++)
+        out[i] = static_cast<u32>((u64(1) << 31) * size / (size + i));
+    return out;
+}
+
+template<int size> requires lut_size<size>
+constexpr inline std::array<u32, size> rsqrt_table = make_rsqrt_lut<size>();
+
+template<int size> requires lut_size<size>
+constexpr inline std::array<u32, size> rcp_table = make_rcp_lut<size>();
+
+// The default tables.
+constexpr inline const std::array<u32, 128>& rsqrt_lut = rsqrt_table<128>;
+constexpr inline const std::array<u32, 128>& rcp_lut = rcp_table<128>;
+
+// Index into a table of the given size, for a raw value whose bit `one`
+// holds the 1.0 of m.
+template<int size, int one>
+constexpr int lut_index(i32 raw) {
+    return (raw >> (one - std::countr_zero(unsigned(size)))) & (size - 1);
+}
 
 template<std::integral T>
 constexpr int ilog2(T value) {
     using ut = std::make_unsigned_t<T>;
     const ut bits = static_cast<ut>(value);
     return static_cast<int>(sizeof(T) * CHAR_BIT) - 
-            std::countl_zero(bits) -
-            std::is_signed_v<T>;
+            std::countl_zero(bits) - 1;
+}
+
+// Constants in Q126, for products wider than a double holds.
+constexpr u128 half_pi_q126   = (u128(0x6487ed5110b4611a) << 64) | 0x62633145c06e0e69;
+constexpr u128 two_by_pi_q126 = (u128(0x28be60db9391054a) << 64) | 0x7f09d5f47d4d3770;
+
+template<typename W>
+consteval W q126_bits(u128 value, int frac) {
+    return static_cast<W>((value + (u128(1) << (125 - frac))) >> (126 - frac));
 }
 
-constexpr trig_t p1 = 0.7853981633974483096;
-constexpr trig_t p3 = 2.3561944901923449288;
-constexpr trig_t p5 = 3.9269908169872415481;
-constexpr trig_t p7 = 5.4977871437821381673;
-constexpr trig_t pstep = 0.63661977236758134308;
+// |s| - q * pi / 2 in trig_t, for the nearest quarter turn q, and q & 3.
+// Cody-Waite without a divide: q comes from a multiply by 2/pi, and pi / 2
+// is split into parts whose products with q stay exact or nearly so.
+//
+// Up to 32-bit bases this is all 64-bit arithmetic, with pi / 2 held to 64
+// bits below trig_t's last one, in a 27-bit head and two 32-bit words. q
+// times the head and the middle word is exact, and q times the low word
+// only decides the final rounding through a ceiling, so the remainder is
+// rounded once from 64 extra bits. For fixed8 through fixed24 it is
+// correctly rounded, which sweep --function=reduce checks over every input
+// of fixed8 and fixed12. 64-bit bases use a head and a 64-bit tail in 128
+// bits.
+template<std::integral base, int fp>
+constexpr trig_t reduce_half_pi(fixed<base, fp> s, int& quadrant) {
+    constexpr bool wide = sizeof(base) > sizeof(i32);
+    using uw = std::conditional_t<wide, u128, u64>;
+    using sw = std::conditional_t<wide, i128, i64>;
+    constexpr int f = trig_t::frac_bits;
+    constexpr int qf = wide ? 63 : 32;
+    constexpr uw two_by_pi = q126_bits<uw>(two_by_pi_q126, qf);
+    constexpr u128 half_pi_all = q126_bits<u128>(half_pi_q126, f + 64);
+
+    const uw u = (s < 0) ? uw(0) - static_cast<uw>(s.raw()) : static_cast<uw>(s.raw());
+    const uw q = (u * two_by_pi + (uw(1) << (qf + fp - 1))) >> (qf + fp);
+    quadrant = static_cast<int>(q & 3);
+
+    sw x;
+    if constexpr(fp > f)
+        x = static_cast<sw>((u + (uw(1) << (fp - f - 1))) >> (fp - f));
+    else
+        x = static_cast<sw>(u << (f - fp));
 
-// ? Factorize these?
+    const sw q_signed = static_cast<sw>(q);
+    if constexpr(wide) {
+        constexpr sw half_pi_hi = static_cast<sw>(half_pi_all >> 64);
+        constexpr sw half_pi_lo = static_cast<sw>(half_pi_all & ~u64(0));
+        const sw r = ((x - q_signed * half_pi_hi) << 64) - q_signed * half_pi_lo;
+        return trig_t::from_raw(static_cast<i32>((r + (sw(1) << 63)) >> 64));
+    }
+    else {
+        constexpr i64 half_pi_hi = static_cast<i64>(half_pi_all >> 64);
+        constexpr i64 half_pi_mid = static_cast<i64>((half_pi_all >> 32) & 0xffffffff);
+        constexpr i64 half_pi_lo = static_cast<i64>(half_pi_all & 0xffffffff);
+
+        // r has 32 extra bits, and the low product the 32 below those.
+        const i64 r = ((x - q_signed * half_pi_hi) << 32) - q_signed * half_pi_mid;
+        const i64 low = (q_signed * half_pi_lo + 0xffffffff) >> 32;
+        return trig_t::from_raw(static_cast<i32>((r + (i64(1) << 31) - low) >> 32));
+    }
+}
+
+// Shared with the batch kernels, which must evaluate the same polynomials.
+
+constexpr trig_t cos_c1 = 0.04166666666666666667;
+constexpr trig_t cos_c2 = 0.00138888888888888888;
+constexpr trig_t cos_c3 = 0.00002480158730158730;
+
+constexpr trig_t sin_c1 = 0.16666666666666666667;
+constexpr trig_t sin_c2 = 0.00833333333333333333;
+constexpr trig_t sin_c3 = 0.00019841269841269841;
 
 // Approximates cos(x) for x: [-pi/4, pi/4]
 constexpr trig_t get_cos(trig_t x) {
-    constexpr trig_t c1 = 0.04166666666666666667;
-    constexpr trig_t c2 = 0.00138888888888888888;
-    constexpr trig_t c3 = 0.00002480158730158730;
     const trig_t x2 = x * x;
     const trig_t x4 = x2 * x2;
     const trig_t x6 = x4 * x2;
-    return 1 - (x2 >> 1) + (x4 * c1) - (x6 * c2) + (x6 * x2 * c3);
+    return 1 - (x2 >> 1) + (x4 * cos_c1) - (x6 * cos_c2) + (x6 * x2 * cos_c3);
 };
 
 // Approximates sin(x) for x: [-pi/4, pi/4]
 constexpr trig_t get_sin(trig_t x) {
-    constexpr trig_t c1 = 0.16666666666666666667;
-    constexpr trig_t c2 = 0.00833333333333333333;
-    constexpr trig_t c3 = 0.00019841269841269841;
     const trig_t x2 = x * x;
     const trig_t x3 = x2 * x;
     const trig_t x5 = x3 * x2;
-    return x - (x3 * c1) + (x5 * c2) - (x5 * x2 * c3);
+    return x - (x3 * sin_c1) + (x5 * sin_c2) - (x5 * x2 * sin_c3);
 };
 
+constexpr trig_t atan_c1 = trig_t(1) / 3;
+constexpr trig_t atan_c2 = trig_t(1) / 5;
+constexpr trig_t atan_c3 = trig_t(1) / 7;
+constexpr trig_t atan_c4 = trig_t(1) / 9;
+
+constexpr trig_t atan_c5  = -0.07277922440465403597;
+constexpr trig_t atan_c6  =  0.33012363557510843171;
+constexpr trig_t atan_c7  = -0.52029663001374293341;
+constexpr trig_t atan_c8  =  0.05631084241194499879;
+constexpr trig_t atan_c9  =  0.99158187828010724285;
+constexpr trig_t atan_c10 =  0.00045766154868510445;
+
+// Approximates atan(x) for x: [0, 1]
+constexpr trig_t atan01(trig_t x) {
+    if (x <= 0.375) {
+        const trig_t x2 = x * x;
+        return x * (1 - x2 * (atan_c1 - x2 * (atan_c2 - x2 * (atan_c3 - x2 * atan_c4))));
+    }
+    else {
+        return x * (x * (x * (x * (atan_c5 * x + atan_c6) + atan_c7) + atan_c8) + atan_c9) + atan_c10;
+    }
+}
+
+// |s| as unsigned, so -min does not overflow.
+template<std::integral base, int fp>
+constexpr std::make_unsigned_t<base> magnitude(fixed<base, fp> s) {
+    using ut = std::make_unsigned_t<base>;
+    const ut raw = static_cast<ut>(s.raw());
+    return (s < 0) ? static_cast<ut>(ut(0) - raw) : raw;
+}
+
+// lo / hi in trig_t, truncated, for 0 <= lo <= hi and hi > 0.
+// Both are first shifted until hi fits in 25 bits. That keeps any inexact
+// quotient more than 2^-25 from an integer, beyond the rounding of a double
+// divide under 2^27, so the batch kernels get the same bits from doubles.
+template<std::unsigned_integral T>
+constexpr trig_t octant_ratio(T lo, T hi) {
+    const int k = std::max(ilog2(hi) - 24, 0);
+    const u64 n = static_cast<u64>(lo >> k) << trig_t::frac_bits;
+    return trig_t::from_raw(static_cast<i32>(n / static_cast<u32>(hi >> k)));
+}
+
+// v * t for a raw value v, cut to base like a product of two raws.
+template<std::integral base, std::integral T>
+constexpr base mul_trig(T v, trig_t t) {
+    using wide_t = std::conditional_t<(sizeof(T) < sizeof(i64)), i64, i128>;
+    return static_cast<base>((static_cast<wide_t>(v) * t.raw()) >> trig_t::frac_bits);
+}
+
+// log2 of a 64-bit format can exceed the 5 integer bits of exp_t.
+
+template<std::integral base>
+using exp_result_t = std::conditional_t<(sizeof(base) > sizeof(i32)), fixed<i64, 56>, exp_t>;
+
 // On some formats, the integer cannot store the number of fraction bits.
 // So, as an emergancy, just set it to the minimum value.
 // Please leave at least 5 integer bits on your formats for stability!
@@ -109,14 +238,15 @@ consteval fixed<base, fp> get_min_exp2_input() {
 
 // Functions specialized for certain algorithms.
 
+template<int size = 128, int iterations = 2> requires lut_size<size>
 constexpr trig_t asin_sqrt(trig_t s) {
     const int log2 = trig_t::frac_bits - impl::ilog2(s.raw());
     const trig_t x = s << (log2 - 1);
-    const int idx = (x & (0xfe << 18)).raw() >> 19;
+    const int idx = lut_index<size, 26>(x.raw());
 
-    trig_t y = trig_t::from_raw(impl::rsqrt_lut[idx] >> 4);
-    y *= 1.5 - (x * y * y);
-    y *= 1.5 - (x * y * y);
+    trig_t y = trig_t::from_raw(rsqrt_table<size>[idx] >> 4);
+    for (int i = 0; i < iterations; i++)
+        y *= 1.5 - (x * y * y);
 
     y *= (x << 1);
 
@@ -128,14 +258,27 @@ constexpr trig_t asin_sqrt(trig_t s) {
 
 using log_t = fixed<int, 27>;
 
+template<int size = 128, int iterations = 2> requires lut_size<size>
 constexpr log_t log2_sqrt(log_t x) {
     const log_t s = x >> 1;
-    const int idx = (s & (0xfe << 18)).raw() >> 19;
-    log_t y = log_t::from_raw(impl::rsqrt_lut[idx] >> 4);
-    y *= 1.5 - (s * y * y);
-    y *= 1.5 - (s * y * y);
+    const int idx = lut_index<size, 26>(s.raw());
+    log_t y = log_t::from_raw(rsqrt_table<size>[idx] >> 4);
+    for (int i = 0; i < iterations; i++)
+        y *= 1.5 - (s * y * y);
     y *= x;
     return y;
 };
 
+// Polynomials of log2 and exp2, shared with the batch kernels.
+
+constexpr log_t log2_c1 =  0.11598391789742051872;
+constexpr log_t log2_c2 = -0.87468467888034107105;
+constexpr log_t log2_c3 =  2.80670941352567426819;
+constexpr log_t log2_c4 = -5.05195558416252410439;
+constexpr log_t log2_c5 =  6.04525303940652847245;
+constexpr log_t log2_c6 = -3.04130610778675780637;
+
+constexpr exp_t exp2_c1 = exp_t(1) / 3;
+constexpr exp_t exp2_c2 = exp_t(1) / 5;
+
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <type_traits>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./math_helper.hpp"
+#include "./fast.hpp"
+
+// Transcendentals in the caller's format.
+//
+// fxd::native::sin(x) and friends take and return fixed<base, fp>, where the
+// math.hpp functions return trig_t or exp_t. They work in native_t<base>, a
+// signed format of the same width with one integer bit, so hfixed12 math stays
+// in 16-bit values and 32-bit products instead of widening into trig_t.
+// Polynomials are the fast.hpp tiers at the caller's frac_bits. Results are
+// rounded to nearest and narrowed with the format's overflow policy, except
+// the logarithms, which saturate to min() and max() like log(0) does.
+
+namespace fxd {
+
+namespace impl {
+
+template<std::integral base>
+using native_t = fixed<std::make_signed_t<base>, int(sizeof(base) * CHAR_BIT) - 2>;
+
+// A raw value with `from` fraction bits, rounded to T and narrowed with its
+// overflow policy.
+template<fixed_point T, int from, typename W>
+constexpr T native_result(W raw) {
+    constexpr int fp = T::frac_bits;
+    if constexpr(from > fp)
+        raw = (raw + (W(1) << (from - fp - 1))) >> (from - fp);
+    else
+        raw = raw << (fp - from);
+    return T::from_raw(narrow<typename T::overflow_type, typename T::base_type>(raw));
+}
+
+// As native_result, but saturating to [T::min(), T::max()] whatever T's
+// policy, for results that leave T's range for inputs in T, like the log
+// of a tiny value.
+template<fixed_point T, int from, typename W>
+constexpr T native_result_clamped(W raw) {
+    constexpr int fp = T::frac_bits;
+    if constexpr(from > fp)
+        raw = (raw + (W(1) << (from - fp - 1))) >> (from - fp);
+    else
+        raw = raw << (fp - from);
+    return T::from_raw(static_cast<typename T::base_type>(std::clamp<W>(raw, W(T::min().raw()), W(T::max().raw()))));
+}
+
+// s in T, for values that fit.
+template<fixed_point T, std::integral base, int fp>
+constexpr T to_native(fixed<base, fp> s) {
+    using wide_t = typename T::next_type;
+    constexpr int wfp = T::frac_bits;
+    const wide_t raw = s.raw();
+    if constexpr(fp > wfp)
+        return T::from_raw(static_cast<typename T::base_type>((raw + (wide_t(1) << (fp - wfp - 1))) >> (fp - wfp)));
+    else
+        return T::from_raw(static_cast<typename T::base_type>(raw << (wfp - fp)));
+}
+
+// The nearest quarter turn q and s - q * pi / 2 in T. The remainder is taken
+// in next_type with pi / 2 to wfp + fp bits, so the error stays far below an
+// ulp of s over its whole range.
+template<fixed_point T, std::integral base, int fp>
+constexpr T native_reduce(fixed<base, fp> s, int& quadrant) {
+    using wide_t = typename T::next_type;
+    constexpr int wfp = T::frac_bits;
+    constexpr int k = wfp + fp;
+    constexpr wide_t two_by_pi = q126_bits<wide_t>(two_by_pi_q126, wfp);
+    constexpr wide_t half_pi_k = q126_bits<wide_t>(half_pi_q126, k);
+
+    const wide_t raw = s.raw();
+    const wide_t q = (raw * two_by_pi + (wide_t(1) << (k - 1))) >> k;
+    quadrant = static_cast<int>(q & 3);
+
+    const wide_t r = (raw << wfp) - q * half_pi_k;
+    if constexpr(fp > 0)
+        return T::from_raw(static_cast<typename T::base_type>((r + (wide_t(1) << (fp - 1))) >> fp));
+    else
+        return T::from_raw(static_cast<typename T::base_type>(r));
+}
+
+// sqrt(u) for u: [0, 1], from the rsqrt table and Newton steps in T.
+template<int bits, fixed_point T>
+constexpr T native_sqrt(T u) {
+    using base = typename T::base_type;
+    constexpr int wfp = T::frac_bits;
+    constexpr int iterations = (bits <= 14) ? 1 : ((bits <= 30) ? 2 : 3);
+
+    if (u <= 0)
+        return 0;
+
+    // u = m * 2^-shift, m: [1, 2)
+    const int shift = wfp - ilog2(u.raw());
+    const T m = T::from_raw(static_cast<base>(u.raw() << shift));
+    const u32 y0 = rsqrt_lut[static_cast<int>(m.raw() >> (wfp - 7)) & 127];
+
+    T y = T::from_raw(static_cast<base>((wfp > 31) ? (base(y0) << (wfp - 31)) : (y0 >> (31 - wfp))));
+    const T half = m >> 1;
+    for (int i = 0; i < iterations; i++)
+        y *= 1.5 - half * y * y;
+
+    const T out = (m * y) >> (shift >> 1);
+    return (shift & 1) ? out * rsqrt_2<T> : out;
+}
+
+template<int bits, fixed_point T>
+constexpr T native_asin(T x) {
+    if (x < 0)
+        return -native_asin<bits>(-x);
+    if (x > 0.5)
+        return half_pi<T> - (native_asin<bits>(native_sqrt<bits>((1 - x) >> 1)) << 1);
+    return fast_asin<bits>(x);
+}
+
+// log2 of the mantissa of s in T, and the exponent.
+template<int bits, fixed_point T, std::integral base, int fp>
+constexpr T native_log2(fixed<base, fp> s, int& exponent) {
+    using ubase = std::make_unsigned_t<base>;
+    constexpr int wfp = T::frac_bits;
+
+    const int msb = ilog2(s.raw());
+    const ubase m = static_cast<ubase>(s.raw());
+    const ubase t = (msb > wfp) ? ubase(m >> (msb - wfp)) : ubase(m << (wfp - msb));
+
+    exponent = msb - fp;
+    return fast_log2<bits>(T::from_raw(static_cast<typename T::base_type>(t & ((ubase(1) << wfp) - 1))));
+}
+
+// log2(s) * c for c < 1. The exponent's share is taken with guard bits below
+// the working format, so it adds no error of its own.
+template<long double c, std::integral base, int fp>
+constexpr fixed<base, fp> native_log2_scaled(fixed<base, fp> s) {
+    using fixed_t = fixed<base, fp>;
+    using work_t = native_t<base>;
+    using wide_t = typename work_t::next_type;
+    constexpr int wfp = work_t::frac_bits;
+    constexpr int guard = std::min(work_t::bits / 2 - 2, 62 - wfp);
+    constexpr wide_t c_wide = static_cast<wide_t>(c * static_cast<long double>(u64(1) << (wfp + guard)) + 0.5L);
+    constexpr work_t c_work = static_cast<double>(c);
+
+    if (s <= 0)
+        return fixed_t::min();
+
+    int exponent;
+    const work_t y = native_log2<fp, work_t>(s, exponent);
+    const wide_t scaled = (wide_t(exponent) * c_wide + (wide_t(1) << guard >> 1)) >> guard;
+    return native_result_clamped<fixed_t, wfp>(scaled + (y * c_work).raw());
+}
+
+}
+
+namespace native {
+
+// Trigonometry
+
+template<std::integral base, int fp>
+constexpr fixed<base, fp> sin(fixed<base, fp> s) {
+    static_assert(fixed<base, fp>::is_signed, "sin only supports signed fixed types!");
+    using work_t = impl::native_t<base>;
+    using wide_t = typename work_t::next_type;
+
+    int quadrant;
+    const work_t x = impl::native_reduce<work_t>(s, quadrant);
+    const wide_t y = ((quadrant & 1) ? impl::fast_cos<fp>(x) : impl::fast_sin<fp>(x)).raw();
+    return impl::native_result<fixed<base, fp>, work_t::frac_bits>((quadrant & 2) ? -y : y);
+}
+
+template<std::integral base, int fp>
+constexpr fixed<base, fp> cos(fixed<base, fp> s) {
+    static_assert(fixed<base, fp>::is_signed, "cos only supports signed fixed types!");
+    using work_t = impl::native_t<base>;
+    using wide_t = typename work_t::next_type;
+
+    int quadrant;
+    const work_t x = impl::native_reduce<work_t>(s, quadrant);
+    const wide_t y = ((quadrant & 1) ? impl::fast_sin<fp>(x) : impl::fast_cos<fp>(x)).raw();
+    return impl::native_result<fixed<base, fp>, work_t::frac_bits>(((quadrant + 1) & 2) ? -y : y);
+}
+
+template<std::integral base, int fp>
+constexpr void sincos(fixed<base, fp> s, fixed<base, fp>& out_sin, fixed<base, fp>& out_cos) {
+    static_assert(fixed<base, fp>::is_signed, "sincos only supports signed fixed types!");
+    using fixed_t = fixed<base, fp>;
+    using work_t = impl::native_t<base>;
+    using wide_t = typename work_t::next_type;
+    constexpr int wfp = work_t::frac_bits;
+
+    int quadrant;
+    const work_t x = impl::native_reduce<work_t>(s, quadrant);
+    const wide_t sin_x = impl::fast_sin<fp>(x).raw();
+    const wide_t cos_x = impl::fast_cos<fp>(x).raw();
+
+    const wide_t y_sin = (quadrant & 1) ? cos_x : sin_x;
+    const wide_t y_cos = (quadrant & 1) ? sin_x : cos_x;
+    out_sin = impl::native_result<fixed_t, wfp>((quadrant & 2) ? -y_sin : y_sin);
+    out_cos = impl::native_result<fixed_t, wfp>(((quadrant + 1) & 2) ? -y_cos : y_cos);
+}
+
+// Inverse Trigonometry
+
+template<std::integral base, int fp>
+constexpr fixed<base, fp> asin(fixed<base, fp> s) {
+    using fixed_t = fixed<base, fp>;
+    using work_t = impl::native_t<base>;
+
+    if (s > 1)
+        return fixed_t::max();
+    if (s < -1)
+        return -fixed_t::max();
+
+    const work_t y = impl::native_asin<fp>(impl::to_native<work_t>(s));
+    return impl::native_result<fixed_t, work_t::frac_bits>(typename work_t::next_type(y.raw()));
+}
+
+template<std::integral base, int fp>
+constexpr fixed<base, fp> acos(fixed<base, fp> s) {
+    using fixed_t = fixed<base, fp>;
+    using work_t = impl::native_t<base>;
+    using wide_t = typename work_t::next_type;
+    constexpr int wfp = work_t::frac_bits;
+
+    if (s > 1)
+        return fixed_t::max();
+    if (s < -1)
+        return fixed_t::max();
+
+    const work_t y = impl::native_asin<fp>(impl::to_native<work_t>(s));
+    return impl::native_result<fixed_t, wfp>(impl::q126_bits<wide_t>(impl::half_pi_q126, wfp) - y.raw());
+}
+
+template<std::integral base, int fp>
+constexpr fixed<base, fp> atan(fixed<base, fp> s) {
+    using fixed_t = fixed<base, fp>;
+    using work_t = impl::native_t<base>;
+    using wide_t = typename work_t::next_type;
+    constexpr int wfp = work_t::frac_bits;
+
+    if (s < 0)
+        return -native::atan(-s);
+
+    if (s <= 1)
+        return impl::native_result<fixed_t, wfp>(wide_t(impl::fast_atan<fp>(impl::to_native<work_t>(s)).raw()));
+
+    const work_t r = work_t::from_raw(static_cast<typename work_t::base_type>((wide_t(1) << (wfp + fp)) / s.raw()));
+    return impl::native_result<fixed_t, wfp>(wide_t((half_pi<work_t> - impl::fast_atan<fp>(r)).raw()));
+}
+
+// Logarithms
+
+template<std::integral base, int fp>
+constexpr fixed<base, fp> log2(fixed<base, fp> s) {
+    using fixed_t = fixed<base, fp>;
+    using work_t = impl::native_t<base>;
+    using wide_t = typename work_t::next_type;
+    constexpr int wfp = work_t::frac_bits;
+
+    if (s <= 0)
+        return fixed_t::min();
+
+    int exponent;
+    const work_t y = impl::native_log2<fp, work_t>(s, exponent);
+    return impl::native_result_clamped<fixed_t, wfp>((wide_t(exponent) << wfp) + y.raw());
+}
+
+template<std::integral base, int fp>
+constexpr fixed<base, fp> log(fixed<base, fp> s) {
+    return impl::native_log2_scaled<0.69314718055994530942L>(s);
+}
+
+template<std::integral base, int fp>
+constexpr fixed<base, fp> log10(fixed<base, fp> s) {
+    return impl::native_log2_scaled<0.30102999566398119521L>(s);
+}
+
+}
+
+}
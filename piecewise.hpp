@@ -0,0 +1,324 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#include "./fixed.hpp"
+#include "./const.hpp"
+#include "./native.hpp"
+#include "./simd.hpp"
+
+// Piecewise polynomials fitted at compile time.
+//
+// table_function<Fn, Segments, Degree, T> approximates a constexpr callable
+// double Fn(double) on T. Its domain is [Fn::lo, Fn::hi] when Fn has those
+// members and the whole of T otherwise, and inputs outside it are clamped.
+// The domain is cut into Segments equal pieces of 2^shift raw values, so the
+// piece is the offset from the domain's start shifted right, with no search.
+// Each piece interpolates Fn at the Chebyshev nodes of degree Degree, which
+// is within a small factor of the minimax fit. Fn is called over whole
+// pieces, so it must also be defined a little past hi.
+//
+// Evaluation is Horner in integers: the offset within the piece as an
+// unsigned fraction t in [0, 1), and coefficients in a signed word of T's
+// width or 32 bits, whichever is larger, with as many fraction bits as the
+// largest piece allows. Products are taken in twice that width and
+// truncated. The result is rounded to nearest and narrowed with T's
+// overflow policy, as in native.hpp. The i32 span kernel gathers each
+// coefficient for eight lanes and matches the scalar path bit for bit.
+//
+// max_error() is the largest |table(x) - Fn(x)|, final rounding included,
+// measured on its first call. It covers every input when the domain holds at
+// most 2^16 raw values, so always for 16-bit formats. Wider domains check
+// pieces of up to 4097 raw values whole, and 4097 evenly spaced inputs of
+// larger ones, ends included, which is then a lower bound.
+
+namespace fxd {
+
+namespace impl {
+
+// cos(pi * x) for x in [0, 1], for the Chebyshev nodes.
+constexpr double cos_pi(double x) {
+    constexpr double pi_d = 3.14159265358979323846;
+    if (x > 0.5)
+        return -cos_pi(1 - x);
+
+    const double a = pi_d * x;
+    double term = 1;
+    double sum = 1;
+    for (int k = 1; k < 20; k++) {
+        term *= -a * a / double((2 * k - 1) * (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double abs_d(double x) {
+    return (x < 0) ? -x : x;
+}
+
+// Monomial coefficients in t of the polynomial through f at the N
+// Chebyshev nodes of [0, 1], from its Newton form.
+template<std::size_t N, typename F>
+constexpr std::array<double, N> chebyshev_fit(F f) {
+    std::array<double, N> t{}, d{};
+    for (std::size_t j = 0; j < N; j++) {
+        t[j] = (1 - cos_pi(double(2 * j + 1) / double(2 * N))) / 2;
+        d[j] = f(t[j]);
+    }
+    for (std::size_t k = 1; k < N; k++)
+        for (std::size_t j = N - 1; j >= k; j--)
+            d[j] = (d[j] - d[j - 1]) / (t[j] - t[j - k]);
+
+    std::array<double, N> c{};
+    c[0] = d[N - 1];
+    for (std::size_t k = N - 1; k-- > 0;) {
+        for (std::size_t i = N - 1; i > 0; i--)
+            c[i] = c[i - 1] - t[k] * c[i];
+        c[0] = d[k] - t[k] * c[0];
+    }
+    return c;
+}
+
+template<typename Fn, fixed_point T>
+consteval double domain_lo() {
+    if constexpr(requires { double(Fn::lo); })
+        return std::max(double(Fn::lo), double(T::min()));
+    else
+        return double(T::min());
+}
+
+template<typename Fn, fixed_point T>
+consteval double domain_hi() {
+    if constexpr(requires { double(Fn::hi); })
+        return std::min(double(Fn::hi), double(T::max()));
+    else
+        return double(T::max());
+}
+
+}
+
+template<typename Fn, std::size_t Segments, std::size_t Degree, fixed_point T>
+class table_function {
+    static_assert(Segments >= 1, "Need at least one segment!");
+    static_assert(Degree <= 8, "Monomial fits above degree 8 lose too much to cancellation!");
+
+    using base = typename T::base_type;
+    using ut = std::make_unsigned_t<base>;
+    using acc_t = std::conditional_t<(sizeof(base) <= sizeof(i32)), i32, i64>;
+    using wide_t = impl::next_int_v<acc_t>;
+    using uwide_t = std::conditional_t<(sizeof(acc_t) == sizeof(i32)), u64, u128>;
+    static constexpr int fp = T::frac_bits;
+    static constexpr int acc_bits = sizeof(acc_t) * CHAR_BIT;
+    static constexpr std::size_t terms = Degree + 1;
+
+    // The raw value nearest v inside the domain, and within T.
+    static constexpr i128 to_raw(double v, bool up) {
+        const double scaled = v * double(u64(1) << fp);
+        i128 raw = static_cast<i128>(scaled);
+        if (up && double(raw) < scaled)
+            raw++;
+        if (!up && double(raw) > scaled)
+            raw--;
+        return std::clamp<i128>(raw, i128(T::min().raw()), i128(T::max().raw()));
+    }
+
+    static constexpr i128 lo_wide = to_raw(impl::domain_lo<Fn, T>(), true);
+    static constexpr i128 hi_wide = to_raw(impl::domain_hi<Fn, T>(), false);
+    static_assert(lo_wide <= hi_wide, "The domain holds no values of T!");
+
+    static constexpr int find_shift() {
+        const u128 span = static_cast<u128>(hi_wide - lo_wide);
+        int s = 0;
+        while ((span >> s) >= Segments)
+            s++;
+        return s;
+    }
+
+public:
+    // Raw values per segment, as a power of two.
+    static constexpr int shift = find_shift();
+    // Fraction bits of t, and of the coefficients.
+    static constexpr int t_bits = acc_bits - 1;
+
+private:
+    static constexpr double x_of(i128 raw) {
+        return double(raw) / double(u64(1) << fp);
+    }
+
+    // Real coefficients of each segment, in t.
+    static constexpr auto fitted = [] {
+        std::array<std::array<double, terms>, Segments> out{};
+        const double width = double(u128(1) << shift) / double(u64(1) << fp);
+        for (std::size_t s = 0; s < Segments; s++) {
+            const double start = x_of(lo_wide + (i128(s) << shift));
+            out[s] = impl::chebyshev_fit<terms>([&](double t) { return double(Fn{}(start + t * width)); });
+        }
+        return out;
+    }();
+
+    // The largest sum of |coefficients|, which bounds every Horner step.
+    static constexpr double bound = [] {
+        double out = 0;
+        for (const auto& c : fitted) {
+            double sum = 0;
+            for (const double v : c)
+                sum += impl::abs_d(v);
+            out = std::max(out, sum);
+        }
+        return out;
+    }();
+
+    static constexpr int find_coefficient_bits() {
+        int w = 0;
+        while (w < 62 && bound * double(u64(1) << (w + 1)) < double(u64(1) << (acc_bits - 2)))
+            w++;
+        return w;
+    }
+
+public:
+    static constexpr int coefficient_bits = find_coefficient_bits();
+    static_assert(bound * double(u64(1) << coefficient_bits) < double(u64(1) << (acc_bits - 2)),
+                  "Function values are too large for the accumulator!");
+
+    static constexpr double lo = impl::domain_lo<Fn, T>();
+    static constexpr double hi = impl::domain_hi<Fn, T>();
+
+private:
+    static constexpr base lo_raw = static_cast<base>(lo_wide);
+    static constexpr base hi_raw = static_cast<base>(hi_wide);
+
+    // Coefficient k of every segment together, for gathers.
+    static constexpr auto coefficients = [] {
+        std::array<std::array<acc_t, Segments>, terms> out{};
+        const double scale = double(u64(1) << coefficient_bits);
+        for (std::size_t s = 0; s < Segments; s++) {
+            for (std::size_t k = 0; k < terms; k++) {
+                const double v = fitted[s][k] * scale;
+                out[k][s] = static_cast<acc_t>(v + ((v < 0) ? -0.5 : 0.5));
+            }
+        }
+        return out;
+    }();
+
+    // The segment of a raw value already clamped to the domain, and t.
+    static constexpr std::size_t locate(base raw, acc_t& t) {
+        const uwide_t offset = static_cast<ut>(static_cast<ut>(raw) - static_cast<ut>(lo_raw));
+        const uwide_t low = offset & ((uwide_t(1) << shift) - 1);
+        if constexpr(shift <= t_bits)
+            t = static_cast<acc_t>(low << (t_bits - shift));
+        else
+            t = static_cast<acc_t>(low >> (shift - t_bits));
+        return static_cast<std::size_t>(offset >> shift);
+    }
+
+public:
+    static constexpr T eval(T x) {
+        acc_t t;
+        const std::size_t s = locate(std::clamp(x.raw(), lo_raw, hi_raw), t);
+
+        acc_t acc = coefficients[Degree][s];
+        for (std::size_t k = Degree; k-- > 0;)
+            acc = static_cast<acc_t>((wide_t(acc) * t) >> t_bits) + coefficients[k][s];
+        return impl::native_result<T, coefficient_bits>(wide_t(acc));
+    }
+
+    static void eval(std::span<const T> in, std::span<T> out);
+
+    constexpr T operator()(T x) const {
+        return eval(x);
+    }
+
+    void operator()(std::span<const T> in, std::span<T> out) const {
+        eval(in, out);
+    }
+
+private:
+    static double measure_error() {
+        constexpr i128 samples = 4096;
+        const bool every = hi_wide - lo_wide < (i128(1) << 16);
+        double worst = 0;
+        auto check = [&](i128 raw) {
+            const T x = T::from_raw(static_cast<base>(raw));
+            worst = std::max(worst, impl::abs_d(double(eval(x)) - double(Fn{}(double(x)))));
+        };
+        for (std::size_t s = 0; s < Segments; s++) {
+            const i128 start = lo_wide + (i128(s) << shift);
+            const i128 last = std::min(start + (i128(1) << shift) - 1, hi_wide);
+            if (start > last)
+                break;
+            if (every || last - start <= samples) {
+                for (i128 raw = start; raw <= last; raw++)
+                    check(raw);
+            }
+            else {
+                for (i128 k = 0; k <= samples; k++)
+                    check(start + (last - start) * k / samples);
+            }
+        }
+        return worst;
+    }
+
+public:
+    static double max_error() {
+        static const double worst = measure_error();
+        return worst;
+    }
+
+#ifdef FXD_X86_SIMD
+private:
+    // Horner over eight lanes, for i32 inputs whose result needs no left
+    // shift, so rounding is one arithmetic shift.
+    static constexpr bool has_kernel = std::is_same_v<base, i32> && coefficient_bits >= fp &&
+                                       coefficient_bits - fp < 31;
+
+    FXD_TARGET_AVX2 static __m256i kernel(__m256i x) {
+        using namespace impl::avx2;
+        x = _mm256_min_epi32(_mm256_max_epi32(x, set1(lo_raw)), set1(hi_raw));
+        const __m256i offset = _mm256_sub_epi32(x, set1(lo_raw));
+
+        __m256i index, t;
+        if constexpr(shift >= 32)
+            index = _mm256_setzero_si256();
+        else
+            index = _mm256_srli_epi32(offset, shift);
+
+        __m256i low = offset;
+        if constexpr(shift < 32)
+            low = _mm256_and_si256(offset, set1(i32((u32(1) << shift) - 1)));
+        if constexpr(shift <= t_bits)
+            t = _mm256_slli_epi32(low, t_bits - shift);
+        else
+            t = _mm256_srli_epi32(low, shift - t_bits);
+
+        __m256i acc = gather(coefficients[Degree].data(), index);
+        for (std::size_t k = Degree; k-- > 0;)
+            acc = _mm256_add_epi32(mul<t_bits>(acc, t), gather(coefficients[k].data(), index));
+
+        if constexpr(coefficient_bits > fp) {
+            constexpr int down = coefficient_bits - fp;
+            acc = _mm256_srai_epi32(_mm256_add_epi32(acc, set1(i32(1) << (down - 1))), down);
+        }
+        return acc;
+    }
+#endif
+};
+
+template<typename Fn, std::size_t Segments, std::size_t Degree, fixed_point T>
+void table_function<Fn, Segments, Degree, T>::eval(std::span<const T> in, std::span<T> out) {
+    std::size_t i = 0;
+#ifdef FXD_X86_SIMD
+    if constexpr(has_kernel)
+        if (impl::has_avx2())
+            i = impl::avx2::map<kernel>(in.data(), out.data(), in.size());
+#endif
+    for (; i < in.size(); i++)
+        out[i] = eval(in[i]);
+}
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+
+#include "./fixed.hpp"
+
+// SIMD kernels are compiled per-function with target attributes, so the
+// library never needs -mavx2. The kernel is picked at runtime, and every
+// batch function keeps a scalar loop as the portable fallback.
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define FXD_X86_SIMD 1
+    #define FXD_TARGET_AVX2 __attribute__((target("avx2")))
+    #include <immintrin.h>
+#endif
+
+namespace fxd::impl {
+
+inline bool has_avx2() {
+#ifdef FXD_X86_SIMD
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+#ifdef FXD_X86_SIMD
+namespace avx2 {
+
+// Eight lanes of i32 raw values. Everything here reproduces the scalar
+// fixed<i32, fp> operators bit for bit, wrap-around included.
+
+FXD_TARGET_AVX2 inline __m256i set1(i32 v) {
+    return _mm256_set1_epi32(v);
+}
+
+template<typename T>
+FXD_TARGET_AVX2 inline __m256i load(const T* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+template<typename T>
+FXD_TARGET_AVX2 inline void store(T* p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+// (a * b) >> shift on a 64-bit product, truncated to 32 bits.
+// The low word of a logical shift equals the low word of an arithmetic one,
+// so AVX2's missing 64-bit arithmetic shift is not needed.
+template<int shift>
+FXD_TARGET_AVX2 inline __m256i mul(__m256i a, __m256i b) {
+    static_assert(shift >= 0 && shift <= 32);
+    const __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(a, b), shift);
+    const __m256i odd  = _mm256_slli_epi64(
+        _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), 32 - shift);
+    return _mm256_blend_epi32(even, odd, 0xaa);
+}
+
+// mul for lanes holding u32.
+template<int shift>
+FXD_TARGET_AVX2 inline __m256i mulu(__m256i a, __m256i b) {
+    static_assert(shift >= 0 && shift <= 32);
+    const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(a, b), shift);
+    const __m256i odd  = _mm256_slli_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), 32 - shift);
+    return _mm256_blend_epi32(even, odd, 0xaa);
+}
+
+// Negates lanes where mask is all ones.
+FXD_TARGET_AVX2 inline __m256i negate_if(__m256i v, __m256i mask) {
+    return _mm256_sub_epi32(_mm256_xor_si256(v, mask), mask);
+}
+
+// Picks b where mask is all ones, a elsewhere.
+FXD_TARGET_AVX2 inline __m256i select(__m256i a, __m256i b, __m256i mask) {
+    return _mm256_blendv_epi8(a, b, mask);
+}
+
+FXD_TARGET_AVX2 inline __m256i less_equal(__m256i a, __m256i b) {
+    return _mm256_xor_si256(_mm256_cmpgt_epi32(a, b), _mm256_set1_epi32(-1));
+}
+
+// Converts a raw fixed<i32, from> to fixed<i32, to> like the scalar
+// conversion operator. Inputs must be non-negative when narrowing.
+template<int from, int to>
+FXD_TARGET_AVX2 inline __m256i convert(__m256i v) {
+    if constexpr(to > from)
+        return _mm256_slli_epi32(v, to - from);
+    else if constexpr(to < from)
+        return _mm256_srai_epi32(v, from - to);
+    else
+        return v;
+}
+
+// Index of the highest set bit of positive lanes, like impl::ilog2.
+// With no two adjacent bits set, the float conversion cannot round up
+// to the next power of two, so its exponent is exact.
+FXD_TARGET_AVX2 inline __m256i ilog2(__m256i v) {
+    const __m256i sparse = _mm256_andnot_si256(_mm256_srli_epi32(v, 1), v);
+    const __m256i exp = _mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(sparse)), 23);
+    return _mm256_sub_epi32(exp, set1(127));
+}
+
+// v >> n for per-lane n of either sign, as in (n > 0) ? (v >> n) : (v << -n).
+// Only valid for non-negative or u32 lanes: the shifts are logical, and the
+// unused direction sees an out of range count, which AVX2 turns into zero.
+FXD_TARGET_AVX2 inline __m256i shift_right(__m256i v, __m256i n) {
+    const __m256i left = _mm256_sllv_epi32(v, _mm256_sub_epi32(_mm256_setzero_si256(), n));
+    return _mm256_or_si256(_mm256_srlv_epi32(v, n), left);
+}
+
+template<typename T>
+FXD_TARGET_AVX2 inline __m256i gather(const T* table, __m256i idx) {
+    static_assert(sizeof(T) == 4);
+    return _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), idx, 4);
+}
+
+// Applies a lane kernel over n elements, returning how many were processed.
+template<__m256i (*kernel)(__m256i), typename T, typename U>
+FXD_TARGET_AVX2 std::size_t map(const T* in, U* out, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        store(out + i, kernel(load(in + i)));
+    return i;
+}
+
+}
+#endif
+
+}
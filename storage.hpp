@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./fixed.hpp"
+
+// A binary container for arrays of one fixed format, laid out as a 64-byte
+// header followed by the raw values:
+//
+//   magic "fxdarray", version, base width in bits, signedness, frac_bits,
+//   endianness, rank, up to four dimensions (outermost first), the element
+//   count and the payload offset, all in the writer's byte order.
+//
+// mapped_array maps a file read-only and hands out a span straight over the
+// payload, which sits 64-byte aligned in the page-aligned mapping, so
+// loading costs a page fault per page touched and no copy. It checks the
+// header against the requested type, and only accepts files in the native
+// byte order, since values are never converted. The overflow and rounding
+// policies are not recorded, as they do not change the raw bits.
+//
+// array_writer streams values with append(). Only the outermost dimension
+// grows, and the header is patched with the final count by close(), so a
+// file that was never closed reads as empty.
+//
+// POSIX only. I/O failures throw std::system_error with the errno, and a
+// file that does not match the requested type throws std::runtime_error.
+
+namespace fxd {
+
+struct array_header {
+    static constexpr std::array<char, 8> expected_magic = { 'f', 'x', 'd', 'a', 'r', 'r', 'a', 'y' };
+    static constexpr u16 current_version = 1;
+    static constexpr std::size_t max_rank = 4;
+    static constexpr u64 payload_alignment = 64;
+
+    std::array<char, 8> magic;
+    u16 version;
+    u8 base_bits;
+    u8 is_signed;
+    u8 frac_bits;
+    u8 little_endian;
+    u8 rank;
+    u8 reserved;
+    std::array<u64, max_rank> shape;
+    u64 count;
+    u64 payload_offset;
+};
+
+static_assert(sizeof(array_header) == array_header::payload_alignment);
+static_assert(std::is_trivially_copyable_v<array_header>);
+
+namespace impl {
+
+template<typename T>
+constexpr bool is_fixed = false;
+
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+constexpr bool is_fixed<fixed<base, fp, ovf, rnd>> = true;
+
+// The header describing an array of fixed_t, with an empty shape.
+template<typename fixed_t>
+consteval array_header header_of() {
+    static_assert(is_fixed<fixed_t>, "Arrays can only hold fixed types!");
+    static_assert(sizeof(fixed_t) == sizeof(typename fixed_t::base_type) && std::is_trivially_copyable_v<fixed_t>,
+                  "fixed must have the layout of its base type!");
+    static_assert(std::endian::native == std::endian::little || std::endian::native == std::endian::big);
+
+    array_header h{};
+    h.magic = array_header::expected_magic;
+    h.version = array_header::current_version;
+    h.base_bits = static_cast<u8>(fixed_t::bits);
+    h.is_signed = fixed_t::is_signed;
+    h.frac_bits = static_cast<u8>(fixed_t::frac_bits);
+    h.little_endian = std::endian::native == std::endian::little;
+    h.payload_offset = sizeof(array_header);
+    return h;
+}
+
+[[noreturn]] inline void throw_errno(const char* what, const std::string& path) {
+    throw std::system_error(errno, std::generic_category(), std::string("fxd: ") + what + " " + path);
+}
+
+inline void write_all(int fd, const void* data, std::size_t size, off_t offset, const std::string& path) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t n = (offset < 0) ? ::write(fd, p, size) : ::pwrite(fd, p, size, offset);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            throw_errno("cannot write", path);
+        }
+        p += n;
+        size -= static_cast<std::size_t>(n);
+        if (offset >= 0)
+            offset += n;
+    }
+}
+
+}
+
+template<typename fixed_t>
+class array_writer {
+    static constexpr array_header format = impl::header_of<fixed_t>();
+
+    int fd = -1;
+    std::string path;
+    array_header header = format;
+
+public:
+    // Creates or truncates path. inner holds the dimensions after the
+    // outermost one, which is counted from the appended values.
+    explicit array_writer(std::string file, std::span<const u64> inner = {}) : path(std::move(file)) {
+        if (inner.size() + 1 > array_header::max_rank)
+            throw std::invalid_argument("fxd: arrays have at most four dimensions");
+        if (std::find(inner.begin(), inner.end(), u64(0)) != inner.end())
+            throw std::invalid_argument("fxd: inner dimensions cannot be zero");
+
+        header.rank = static_cast<u8>(inner.size() + 1);
+        std::copy(inner.begin(), inner.end(), header.shape.begin() + 1);
+
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+            impl::throw_errno("cannot create", path);
+
+        try {
+            impl::write_all(fd, &header, sizeof(header), -1, path);
+        }
+        catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    array_writer(std::string file, std::initializer_list<u64> inner)
+        : array_writer(std::move(file), std::span<const u64>(inner.begin(), inner.size())) {}
+
+    array_writer(const array_writer&) = delete;
+    array_writer& operator=(const array_writer&) = delete;
+
+    // Closes without reporting errors; call close() to see them.
+    ~array_writer() {
+        if (fd >= 0) {
+            try { close(); } catch (...) {}
+        }
+    }
+
+    void append(std::span<const fixed_t> values) {
+        impl::write_all(fd, values.data(), values.size_bytes(), -1, path);
+        header.count += values.size();
+    }
+
+    u64 size() const {
+        return header.count;
+    }
+
+    // Writes the final shape into the header. The count must fill whole
+    // rows of the inner dimensions.
+    void close() {
+        u64 row = 1;
+        for (std::size_t i = 1; i < header.rank; i++)
+            row *= header.shape[i];
+
+        const int f = std::exchange(fd, -1);
+        if (header.count % row != 0) {
+            ::close(f);
+            throw std::invalid_argument("fxd: " + path + " does not hold whole rows");
+        }
+
+        header.shape[0] = header.count / row;
+        try {
+            impl::write_all(f, &header, sizeof(header), 0, path);
+        }
+        catch (...) {
+            ::close(f);
+            throw;
+        }
+        if (::close(f) != 0)
+            impl::throw_errno("cannot close", path);
+    }
+};
+
+// Writes values in one go. The shape defaults to one dimension, and must
+// multiply out to values.size().
+template<std::integral base, int fp, overflow_policy ovf, rounding_policy rnd>
+void write_array(const std::string& path, std::span<const fixed<base, fp, ovf, rnd>> values,
+                 std::initializer_list<u64> shape = {}) {
+    if (shape.size() > array_header::max_rank)
+        throw std::invalid_argument("fxd: arrays have at most four dimensions");
+
+    u64 product = 1;
+    for (const u64 d : shape)
+        product *= d;
+    if (shape.size() > 0 && product != values.size())
+        throw std::invalid_argument("fxd: shape does not match the values");
+
+    const std::span<const u64> inner(shape.begin(), shape.size());
+    array_writer<fixed<base, fp, ovf, rnd>> writer(path, inner.empty() ? inner : inner.subspan(1));
+    writer.append(values);
+    writer.close();
+}
+
+template<typename fixed_t>
+class mapped_array {
+    static constexpr array_header format = impl::header_of<fixed_t>();
+
+    void* mapping = nullptr;
+    std::size_t mapped_size = 0;
+    array_header header{};
+
+    void check(const std::string& path, u64 file_size) const {
+        auto fail = [&](const char* why) {
+            throw std::runtime_error("fxd: " + path + " " + why);
+        };
+
+        if (header.magic != array_header::expected_magic)
+            fail("is not a fixed array");
+        if (header.version != array_header::current_version)
+            fail("has an unsupported version");
+        if (header.little_endian != format.little_endian)
+            fail("was written in the other byte order");
+        if (header.base_bits != format.base_bits || header.is_signed != format.is_signed ||
+            header.frac_bits != format.frac_bits)
+            fail("holds a different fixed format");
+        if (header.rank == 0 || header.rank > array_header::max_rank ||
+            header.payload_offset % array_header::payload_alignment != 0)
+            fail("has a corrupt header");
+
+        u64 product = 1;
+        for (std::size_t i = 0; i < header.rank; i++)
+            product *= header.shape[i];
+        if (product != header.count)
+            fail("has a shape that does not match its count");
+        if (header.payload_offset > file_size ||
+            header.count > (file_size - header.payload_offset) / sizeof(fixed_t))
+            fail("is truncated");
+    }
+
+public:
+    explicit mapped_array(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            impl::throw_errno("cannot open", path);
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            const int e = errno;
+            ::close(fd);
+            errno = e;
+            impl::throw_errno("cannot stat", path);
+        }
+
+        mapped_size = static_cast<std::size_t>(st.st_size);
+        if (mapped_size < sizeof(array_header)) {
+            ::close(fd);
+            throw std::runtime_error("fxd: " + path + " is too short for a fixed array");
+        }
+
+        void* p = ::mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+        const int e = errno;
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            errno = e;
+            impl::throw_errno("cannot map", path);
+        }
+        mapping = p;
+
+        std::memcpy(&header, mapping, sizeof(header));
+        try {
+            check(path, mapped_size);
+        }
+        catch (...) {
+            ::munmap(mapping, mapped_size);
+            throw;
+        }
+    }
+
+    mapped_array(mapped_array&& other) noexcept
+        : mapping(std::exchange(other.mapping, nullptr)),
+          mapped_size(std::exchange(other.mapped_size, 0)),
+          header(other.header) {}
+
+    mapped_array& operator=(mapped_array&& other) noexcept {
+        std::swap(mapping, other.mapping);
+        std::swap(mapped_size, other.mapped_size);
+        std::swap(header, other.header);
+        return *this;
+    }
+
+    ~mapped_array() {
+        if (mapping)
+            ::munmap(mapping, mapped_size);
+    }
+
+    // Valid while this object lives.
+    std::span<const fixed_t> values() const {
+        const char* payload = static_cast<const char*>(mapping) + header.payload_offset;
+        return { reinterpret_cast<const fixed_t*>(payload), static_cast<std::size_t>(header.count) };
+    }
+
+    std::span<const u64> shape() const {
+        return { header.shape.data(), header.rank };
+    }
+
+    std::size_t size() const {
+        return static_cast<std::size_t>(header.count);
+    }
+};
+
+}
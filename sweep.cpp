@@ -0,0 +1,509 @@
+// Accuracy sweep: every raw input of a format through each function in
+// math.hpp, compared against double precision libm, whose error is far
+// below the last bit of any 32-bit fixed result. Reports max and mean ULP
+// error in the output format, the worst input and the ns/op next to it,
+// and marks the formats on each function's speed/accuracy Pareto front.
+//
+//   g++ -std=c++20 -O2 -pthread sweep.cpp -o sweep
+//   ./sweep [--csv] [--function=<name>] [--format=<name>] [--stride=<n>]
+//           [--pairs=<n>] [--threads=<n>]
+//
+// Unary functions see all 2^16 or 2^32 raw inputs, split across all cores;
+// --stride=n samples every n-th input of the 32-bit formats. Two-argument functions take --pairs
+// random raw pairs. Inputs whose true result is not finite or does not fit
+// the output format are skipped, as is min() for signed formats, which
+// several functions negate. Functions that promise to saturate are instead
+// checked against the true result clamped to the format, infinities included.
+// The reference runs first, so skipped inputs never call the function.
+//
+// reduce checks the sin and cos range reduction against the exact remainder
+// instead, for formats up to 32 bits with at most trig_t's fraction bits.
+//
+// Cost, measured on one core: a unary function takes about 2 core-minutes
+// per 32-bit format (CORDIC rows about 12), and the default 2^28 pairs of
+// a two-argument function about 15 core-seconds. A full run of every
+// function and format is about 15 core-hours, so half an hour on 32
+// cores. On fewer cores, narrow it with --function and --format, or
+// sample: --stride=256 --pairs=1048576 runs everything in about 5 minutes.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "fixed.hpp"
+#include "math.hpp"
+#include "fast.hpp"
+#include "native.hpp"
+#include "angle.hpp"
+#include "cordic.hpp"
+
+namespace {
+
+struct options {
+    bool csv = false;
+    std::string function;
+    std::string format;
+    std::uint64_t stride = 1;
+    std::uint64_t pairs = std::uint64_t(1) << 28;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+struct stats {
+    std::uint64_t tested = 0;
+    std::uint64_t skipped = 0;
+    double max_ulp = 0;
+    double sum_ulp = 0;
+    double max_abs = 0;
+    double worst_x = 0;
+    double worst_y = 0;
+
+    void add(double ulp, double abs, double x, double y) {
+        tested++;
+        sum_ulp += ulp;
+        if (ulp > max_ulp) {
+            max_ulp = ulp;
+            max_abs = abs;
+            worst_x = x;
+            worst_y = y;
+        }
+    }
+
+    void merge(const stats& other) {
+        tested += other.tested;
+        skipped += other.skipped;
+        sum_ulp += other.sum_ulp;
+        if (other.max_ulp > max_ulp) {
+            max_ulp = other.max_ulp;
+            max_abs = other.max_abs;
+            worst_x = other.worst_x;
+            worst_y = other.worst_y;
+        }
+    }
+};
+
+struct result {
+    std::string function;
+    std::string format;
+    bool binary;
+    stats s;
+    double ns_op;
+    bool pareto = false;
+};
+
+volatile std::uint64_t sink = 0;
+
+// Runs work(begin, end, stats&) over [0, n) in chunks handed out to all
+// threads, and merges their stats.
+template<typename F>
+stats parallel(const options& opt, std::uint64_t n, F work) {
+    constexpr std::uint64_t chunk = 1 << 16;
+    std::atomic<std::uint64_t> next = 0;
+    std::vector<stats> partial(opt.threads);
+    std::vector<std::thread> pool;
+
+    for (unsigned t = 0; t < opt.threads; t++) {
+        pool.emplace_back([&, t] {
+            for (;;) {
+                const std::uint64_t begin = next.fetch_add(chunk);
+                if (begin >= n)
+                    break;
+                work(begin, std::min(n, begin + chunk), partial[t]);
+            }
+        });
+    }
+
+    stats total;
+    for (unsigned t = 0; t < opt.threads; t++) {
+        pool[t].join();
+        total.merge(partial[t]);
+    }
+    return total;
+}
+
+// Whether a reference result can be checked in Out, clamping it first for
+// functions that saturate. Runs before the function itself, so inputs that
+// are skipped cost only the reference.
+template<typename Out>
+bool testable(double& expect, bool saturates) {
+    if (saturates && !std::isnan(expect))
+        expect = std::clamp(expect, double(Out::min()), double(Out::max()));
+    return std::isfinite(expect) && expect <= double(Out::max()) && expect >= double(Out::min());
+}
+
+template<typename Out>
+void record(Out out, double expect, double x, double y, stats& s) {
+    constexpr double ulp_scale = double(std::uint64_t(1) << Out::frac_bits);
+    const double abs = std::abs(double(out) - expect);
+    s.add(abs * ulp_scale, abs, x, y);
+}
+
+template<typename T>
+bool skip_raw(typename T::base_type raw) {
+    return T::is_signed && raw == std::numeric_limits<typename T::base_type>::min();
+}
+
+// Best of five timed passes over the inputs, in ns per call.
+template<typename T, typename F>
+double time_op(const std::vector<T>& xs, const std::vector<T>& ys, F f) {
+    if (xs.empty())
+        return 0;
+
+    double best = 1e300;
+    for (int run = 0; run < 5; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        std::uint64_t acc = 0;
+        for (int rep = 0; rep < 16; rep++)
+            for (std::size_t i = 0; i < xs.size(); i++)
+                acc += static_cast<std::uint64_t>(f(xs[i], ys[i]).raw());
+        const auto end = std::chrono::steady_clock::now();
+        sink = sink + acc;
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / (16.0 * xs.size()));
+    }
+    return best;
+}
+
+struct sweep {
+    const options& opt;
+    std::vector<result>& results;
+    std::string_view format;
+
+    bool wanted(std::string_view function) const {
+        return (opt.function.empty() || function == opt.function) &&
+               (opt.format.empty() || format == opt.format);
+    }
+
+    // saturates checks out of range results against min() and max()
+    // instead of skipping them.
+    template<typename T, typename F, typename R>
+    void unary(std::string_view function, F f, R ref, bool saturates = false) {
+        if (!wanted(function))
+            return;
+
+        using base = typename T::base_type;
+        using Out = decltype(f(T()));
+        constexpr std::uint64_t total = std::uint64_t(1) << T::bits;
+        const std::uint64_t stride = (T::bits > 16) ? opt.stride : 1;
+        const std::uint64_t n = (total + stride - 1) / stride;
+
+        const stats s = parallel(opt, n, [&](std::uint64_t begin, std::uint64_t end, stats& st) {
+            for (std::uint64_t i = begin; i < end; i++) {
+                const base raw = static_cast<base>(i * stride);
+                if (skip_raw<T>(raw)) {
+                    st.skipped++;
+                    continue;
+                }
+
+                const T x = T::from_raw(raw);
+                double expect = ref(double(x));
+                if (!testable<Out>(expect, saturates)) {
+                    st.skipped++;
+                    continue;
+                }
+                record(f(x), expect, double(x), 0, st);
+            }
+        });
+
+        // Time on evenly spread inputs the sweep accepted.
+        std::vector<T> xs;
+        for (std::uint64_t i = 0; i < 65536; i++) {
+            const base raw = static_cast<base>(i * (total / 65536));
+            const T x = T::from_raw(raw);
+            double expect = ref(double(x));
+            if (!skip_raw<T>(raw) && testable<Out>(expect, saturates))
+                xs.push_back(x);
+        }
+
+        results.push_back({ std::string(function), std::string(format), false, s,
+                            time_op(xs, xs, [&](T x, T) { return f(x); }) });
+    }
+
+    template<typename T, typename F, typename R>
+    void binary(std::string_view function, F f, R ref) {
+        if (!wanted(function))
+            return;
+
+        using base = typename T::base_type;
+        using Out = decltype(f(T(), T()));
+        auto pair = [](std::mt19937_64& rng) {
+            const std::uint64_t r = rng();
+            return std::pair{ T::from_raw(static_cast<base>(r)), T::from_raw(static_cast<base>(r >> 32)) };
+        };
+
+        // One generator per chunk keeps the inputs independent of the thread count.
+        const stats s = parallel(opt, opt.pairs, [&](std::uint64_t begin, std::uint64_t end, stats& st) {
+            std::mt19937_64 rng(begin);
+            for (std::uint64_t i = begin; i < end; i++) {
+                const auto [x, y] = pair(rng);
+                if (skip_raw<T>(x.raw()) || skip_raw<T>(y.raw())) {
+                    st.skipped++;
+                    continue;
+                }
+                double expect = ref(double(x), double(y));
+                if (!testable<Out>(expect, false)) {
+                    st.skipped++;
+                    continue;
+                }
+                record(f(x, y), expect, double(x), double(y), st);
+            }
+        });
+
+        std::vector<T> xs, ys;
+        std::mt19937_64 rng(~0ull);
+        for (int i = 0; i < 65536; i++) {
+            const auto [x, y] = pair(rng);
+            double expect = ref(double(x), double(y));
+            if (!skip_raw<T>(x.raw()) && !skip_raw<T>(y.raw()) && testable<Out>(expect, false)) {
+                xs.push_back(x);
+                ys.push_back(y);
+            }
+        }
+
+        results.push_back({ std::string(function), std::string(format), true, s, time_op(xs, ys, f) });
+    }
+
+    // impl::reduce_half_pi against the exact remainder, from pi / 2 in Q123
+    // and 128-bit integers, in trig_t ulp. The reduction may pick either
+    // quarter turn next to |x| / (pi / 2) when that is close to a half, so
+    // the reference takes the neighbour with the same quadrant. A max ulp
+    // of at most 0.5 means every remainder is correctly rounded.
+    template<typename T>
+    void reduction(std::string_view function) {
+        if (!wanted(function))
+            return;
+
+        using base = typename T::base_type;
+        using fxd::i128;
+        using fxd::u128;
+        constexpr int fp = T::frac_bits;
+        constexpr int f = fxd::trig_t::frac_bits;
+        constexpr u128 two_by_pi = fxd::impl::q126_bits<u128>(fxd::impl::two_by_pi_q126, 64);
+        constexpr u128 half_pi = fxd::impl::q126_bits<u128>(fxd::impl::half_pi_q126, f + 96);
+        constexpr i128 half_pi_hi = static_cast<i128>(half_pi >> 64);
+        constexpr i128 half_pi_lo = static_cast<i128>(half_pi & ~std::uint64_t(0));
+        constexpr double scale = 0x1p-96;
+
+        auto reduce = [](T x) {
+            int quadrant;
+            const fxd::trig_t r = fxd::impl::reduce_half_pi(x, quadrant);
+            return std::pair{ r, quadrant };
+        };
+
+        constexpr std::uint64_t total = std::uint64_t(1) << T::bits;
+        const std::uint64_t stride = (T::bits > 16) ? opt.stride : 1;
+        const std::uint64_t n = (total + stride - 1) / stride;
+
+        const stats s = parallel(opt, n, [&](std::uint64_t begin, std::uint64_t end, stats& st) {
+            for (std::uint64_t i = begin; i < end; i++) {
+                const base raw = static_cast<base>(i * stride);
+                const T x = T::from_raw(raw);
+                const auto [r, quadrant] = reduce(x);
+
+                const u128 u = (raw < 0) ? u128(0) - static_cast<u128>(raw) : static_cast<u128>(raw);
+                i128 q = static_cast<i128>((u * two_by_pi + (u128(1) << (63 + fp))) >> (64 + fp));
+                if (((q + 1) & 3) == quadrant)
+                    q++;
+                else if (q > 0 && ((q - 1) & 3) == quadrant)
+                    q--;
+
+                const i128 exact = ((static_cast<i128>(u << (f - fp + 32)) - q * half_pi_hi) << 64) - q * half_pi_lo;
+                const i128 diff = (static_cast<i128>(r.raw()) << 96) - exact;
+                const double ulp = std::abs(double(diff) * scale);
+                st.add(((q & 3) == quadrant) ? ulp : 1e9, ulp / double(std::uint64_t(1) << f), double(x), 0);
+            }
+        });
+
+        std::vector<T> xs;
+        for (std::uint64_t i = 0; i < 65536; i++)
+            xs.push_back(T::from_raw(static_cast<base>(i * (total / 65536))));
+        results.push_back({ std::string(function), std::string(format), false, s,
+                            time_op(xs, xs, [&](T x, T) { return reduce(x).first; }) });
+    }
+};
+
+template<typename T>
+void run_format(const options& opt, std::vector<result>& results, std::string_view format) {
+    sweep s{ opt, results, format };
+    using fxd::exp_t;
+
+    s.unary<T>("sqrt",  [](T x) { return fxd::sqrt(x); },  [](double x) { return std::sqrt(x); });
+    s.unary<T>("rsqrt", [](T x) { return fxd::rsqrt(x); }, [](double x) { return 1 / std::sqrt(x); });
+    s.unary<T>("rcp",   [](T x) { return fxd::rcp(x); },   [](double x) { return 1 / x; });
+    s.unary<T>("cbrt",  [](T x) { return fxd::cbrt(x); },  [](double x) { return std::cbrt(x); });
+    s.binary<T>("hypot", [](T x, T y) { return fxd::hypot(x, y); }, [](double x, double y) { return std::hypot(x, y); });
+    s.binary<T>("to_polar[r]", [](T x, T y) { T r; fxd::trig_t t; fxd::to_polar(x, y, r, t); return r; },
+        [](double x, double y) { return std::hypot(x, y); });
+    if constexpr(sizeof(typename T::base_type) <= sizeof(fxd::i32)) {
+        s.binary<T>("hypot[cordic]", [](T x, T y) { return fxd::cordic::hypot(x, y); }, [](double x, double y) { return std::hypot(x, y); });
+        s.binary<T>("atan2[cordic]", [](T y, T x) { return fxd::cordic::atan2(y, x); }, [](double y, double x) { return std::atan2(y, x); });
+    }
+
+    s.unary<T>("log2",  [](T x) { return fxd::log2(x); },  [](double x) { return std::log2(x); });
+    s.unary<T>("log",   [](T x) { return fxd::log(x); },   [](double x) { return std::log(x); });
+    s.unary<T>("log10", [](T x) { return fxd::log10(x); }, [](double x) { return std::log10(x); });
+
+    s.unary<T>("exp2",  [](T x) { return fxd::exp2(x); },  [](double x) { return std::exp2(x); });
+    s.unary<T>("exp",   [](T x) { return fxd::exp(x); },   [](double x) { return std::exp(x); });
+    s.unary<T>("exp10", [](T x) { return fxd::exp10(x); }, [](double x) { return std::pow(10.0, x); });
+    s.binary<T>("pow", [](T x, T y) { return fxd::pow(x, exp_t(y)); },
+                       [](double x, double y) { return std::pow(x, double(exp_t(y))); });
+
+    s.unary<T>("log2[fast]", [](T x) { return fxd::fast::log2(x); }, [](double x) { return std::log2(x); });
+    s.unary<T>("exp2[fast]", [](T x) { return fxd::fast::exp2(x); }, [](double x) { return std::exp2(x); });
+    s.unary<T>("exp[fast]",  [](T x) { return fxd::fast::exp(x); },  [](double x) { return std::exp(x); });
+
+    s.unary<T>("log2[native]",  [](T x) { return fxd::native::log2(x); },  [](double x) { return std::log2(x); }, true);
+    s.unary<T>("log[native]",   [](T x) { return fxd::native::log(x); },   [](double x) { return std::log(x); }, true);
+    s.unary<T>("log10[native]", [](T x) { return fxd::native::log10(x); }, [](double x) { return std::log10(x); }, true);
+
+    if constexpr(T::is_signed && sizeof(typename T::base_type) <= sizeof(fxd::i32) &&
+                 T::frac_bits <= fxd::trig_t::frac_bits)
+        s.reduction<T>("reduce");
+
+    if constexpr(T::is_signed) {
+        s.unary<T>("sin",  [](T x) { return fxd::sin(x); },  [](double x) { return std::sin(x); });
+        s.unary<T>("cos",  [](T x) { return fxd::cos(x); },  [](double x) { return std::cos(x); });
+        s.unary<T>("tan",  [](T x) { return fxd::tan(x); },  [](double x) { return std::tan(x); });
+        s.unary<T>("asin", [](T x) { return fxd::asin(x); }, [](double x) { return std::asin(x); });
+        s.unary<T>("acos", [](T x) { return fxd::acos(x); }, [](double x) { return std::acos(x); });
+        s.unary<T>("atan", [](T x) { return fxd::atan(x); }, [](double x) { return std::atan(x); });
+        s.binary<T>("atan2", [](T y, T x) { return fxd::atan2(y, x); }, [](double y, double x) { return std::atan2(y, x); });
+
+        s.unary<T>("sin[fast]", [](T x) { return fxd::fast::sin(x); }, [](double x) { return std::sin(x); });
+        s.unary<T>("cos[fast]", [](T x) { return fxd::fast::cos(x); }, [](double x) { return std::cos(x); });
+        s.unary<T>("sin[native]",  [](T x) { return fxd::native::sin(x); },  [](double x) { return std::sin(x); });
+        s.unary<T>("cos[native]",  [](T x) { return fxd::native::cos(x); },  [](double x) { return std::cos(x); });
+        s.unary<T>("asin[native]", [](T x) { return fxd::native::asin(x); }, [](double x) { return std::asin(x); });
+        s.unary<T>("acos[native]", [](T x) { return fxd::native::acos(x); }, [](double x) { return std::acos(x); });
+        s.unary<T>("atan[native]", [](T x) { return fxd::native::atan(x); }, [](double x) { return std::atan(x); });
+        s.unary<T>("sin[cordic]",  [](T x) { return fxd::cordic::sin(x); },  [](double x) { return std::sin(x); });
+        s.unary<T>("cos[cordic]",  [](T x) { return fxd::cordic::cos(x); },  [](double x) { return std::cos(x); });
+        s.unary<T>("sin[angle]",   [](T x) { return fxd::sin(fxd::angle32(x)); }, [](double x) { return std::sin(x); });
+        s.unary<T>("cos[angle]",   [](T x) { return fxd::cos(fxd::angle32(x)); }, [](double x) { return std::cos(x); });
+    }
+}
+
+// The function without its [variant] suffix: sin for sin[fast].
+std::string_view base_name(std::string_view function) {
+    return function.substr(0, function.find('['));
+}
+
+// A result is on its function's Pareto front when no other variant or
+// format of the same base function is both at least as fast and at least
+// as accurate in absolute terms, and strictly better in one of the two.
+// So sin competes with sin[fast], sin[native], sin[cordic] and sin[angle]
+// across every format.
+void mark_pareto(std::vector<result>& results) {
+    for (auto& r : results) {
+        r.pareto = r.s.tested > 0;
+        for (const auto& o : results) {
+            if (&o == &r || base_name(o.function) != base_name(r.function) || o.s.tested == 0)
+                continue;
+            const bool no_worse = o.ns_op <= r.ns_op && o.s.max_abs <= r.s.max_abs;
+            const bool better = o.ns_op < r.ns_op || o.s.max_abs < r.s.max_abs;
+            if (no_worse && better)
+                r.pareto = false;
+        }
+    }
+}
+
+double mean_ulp(const stats& s) {
+    return s.tested ? s.sum_ulp / double(s.tested) : 0;
+}
+
+void print_table(const std::vector<result>& results) {
+    std::cout << std::left << std::setw(10) << "function" << std::setw(10) << "format"
+              << std::right << std::setw(12) << "tested" << std::setw(12) << "skipped"
+              << std::setw(14) << "max ulp" << std::setw(14) << "mean ulp" << std::setw(12) << "max abs"
+              << std::setw(30) << "worst input" << std::setw(9) << "ns/op" << "  pareto\n";
+
+    for (const auto& r : results) {
+        std::ostringstream worst;
+        worst << std::setprecision(9) << r.s.worst_x;
+        if (r.binary)
+            worst << ", " << r.s.worst_y;
+
+        std::cout << std::left << std::setw(10) << r.function << std::setw(10) << r.format
+                  << std::right << std::setw(12) << r.s.tested << std::setw(12) << r.s.skipped
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(14) << r.s.max_ulp << std::setw(14) << mean_ulp(r.s)
+                  << std::scientific << std::setw(12) << r.s.max_abs
+                  << std::setw(30) << worst.str()
+                  << std::fixed << std::setw(9) << r.ns_op << (r.pareto ? "  *" : "") << '\n';
+    }
+}
+
+void print_csv(const std::vector<result>& results) {
+    std::cout << "function,format,tested,skipped,max_ulp,mean_ulp,max_abs,worst_x,worst_y,ns_op,pareto\n";
+    std::cout << std::setprecision(9);
+    for (const auto& r : results) {
+        std::cout << r.function << ',' << r.format << ',' << r.s.tested << ',' << r.s.skipped << ','
+                  << r.s.max_ulp << ',' << mean_ulp(r.s) << ',' << r.s.max_abs << ','
+                  << r.s.worst_x << ',' << (r.binary ? r.s.worst_y : 0.0) << ','
+                  << r.ns_op << ',' << int(r.pareto) << '\n';
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    options opt;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        auto value = [&](std::string_view name) { return std::string(arg.substr(name.size())); };
+
+        if (arg == "--csv")
+            opt.csv = true;
+        else if (arg.starts_with("--function="))
+            opt.function = value("--function=");
+        else if (arg.starts_with("--format="))
+            opt.format = value("--format=");
+        else if (arg.starts_with("--stride="))
+            opt.stride = std::max<std::uint64_t>(1, std::stoull(value("--stride=")));
+        else if (arg.starts_with("--pairs="))
+            opt.pairs = std::stoull(value("--pairs="));
+        else if (arg.starts_with("--threads="))
+            opt.threads = std::max(1, std::stoi(value("--threads=")));
+        else {
+            std::cerr << "usage: " << argv[0] << " [--csv] [--function=<name>] [--format=<name>]"
+                         " [--stride=<n>] [--pairs=<n>] [--threads=<n>]\n";
+            return 1;
+        }
+    }
+
+    std::vector<result> results;
+    run_format<fxd::hfixed8>(opt, results, "hfixed8");
+    run_format<fxd::hfixed12>(opt, results, "hfixed12");
+    run_format<fxd::uhfixed8>(opt, results, "uhfixed8");
+    run_format<fxd::uhfixed12>(opt, results, "uhfixed12");
+    run_format<fxd::fixed8>(opt, results, "fixed8");
+    run_format<fxd::fixed12>(opt, results, "fixed12");
+    run_format<fxd::fixed16>(opt, results, "fixed16");
+    run_format<fxd::fixed18>(opt, results, "fixed18");
+    run_format<fxd::fixed20>(opt, results, "fixed20");
+    run_format<fxd::fixed24>(opt, results, "fixed24");
+    run_format<fxd::ufixed8>(opt, results, "ufixed8");
+    run_format<fxd::ufixed12>(opt, results, "ufixed12");
+    run_format<fxd::ufixed16>(opt, results, "ufixed16");
+    run_format<fxd::ufixed18>(opt, results, "ufixed18");
+    run_format<fxd::ufixed20>(opt, results, "ufixed20");
+    run_format<fxd::ufixed24>(opt, results, "ufixed24");
+    run_format<fxd::exp_t>(opt, results, "exp_t");
+    run_format<fxd::trig_t>(opt, results, "trig_t");
+    run_format<fxd::frac_t>(opt, results, "frac_t");
+
+    mark_pareto(results);
+    if (opt.csv)
+        print_csv(results);
+    else
+        print_table(results);
+}
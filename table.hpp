@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "./fixed.hpp"
+
+// Full-table evaluation for formats of 16 bits or fewer.
+//
+// All inputs of such a format fit in one table, which beats the polynomial
+// and Newton paths and is correctly rounded. With FXD_FULL_TABLES defined,
+// sin, cos, sincos, sqrt, rsqrt, exp2 and log2 look these formats up, in
+// both the scalar and the span functions. fxd::table:: has the same lookups
+// whether or not the macro is defined.
+//
+// A table holds one result per input: 128 KB for 16-bit results, 256 KB
+// for trig_t and exp_t. Each is built on first use, once and thread-safely.
+
+namespace fxd::impl {
+
+#ifdef FXD_FULL_TABLES
+template<std::integral base>
+constexpr bool full_tables = sizeof(base) <= sizeof(i16);
+#else
+template<std::integral base>
+constexpr bool full_tables = false;
+#endif
+
+// Tabulated functions, defined at the end of math.hpp. Each has a double
+// reference() and the generic() path that skips the tables.
+struct sin_fn;
+struct cos_fn;
+struct sqrt_fn;
+struct rsqrt_fn;
+struct exp2_fn;
+struct log2_fn;
+
+// Rounds the reference result to nearest. Where it is not finite or out of
+// the result's range, the generic result is kept, so edge cases match.
+template<typename fn, typename In>
+const auto& full_table() {
+    using Out = decltype(fn::generic(In{}));
+    using in_base = std::make_unsigned_t<typename In::base_type>;
+    using out_base = typename Out::base_type;
+    constexpr std::size_t size = std::size_t(1) << In::bits;
+
+    static const std::vector<Out> table = [] {
+        std::vector<Out> out(size);
+        for (std::size_t i = 0; i < size; i++) {
+            const In x = In::from_raw(static_cast<in_base>(i));
+            const double y = std::nearbyint(std::ldexp(fn::reference(double(x)), Out::frac_bits));
+
+            const bool fits = std::isfinite(y) &&
+                y >= double(Out::min().raw()) && y <= double(Out::max().raw());
+            out[i] = fits ? Out::from_raw(static_cast<out_base>(y)) : fn::generic(x);
+        }
+        return out;
+    }();
+    return table;
+}
+
+template<typename fn, typename In>
+auto full_table_lookup(In x) {
+    using in_base = std::make_unsigned_t<typename In::base_type>;
+    return full_table<fn, In>()[static_cast<in_base>(x.raw())];
+}
+
+}